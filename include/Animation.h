@@ -1,33 +1,45 @@
 #pragma once
 
-#include "SFML/Graphics/Sprite.hpp"
 #include "Vec2.h"
 
-#include <SFML/Graphics.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <cstddef>
+#include <string>
 
+// dense index of a texture or animation, resolved from its name once at
+// load time so that the game loop never looks anything up by string
+typedef size_t AssetId;
+const AssetId NO_ASSET = (AssetId)-1;
+
+// immutable description of an animation, owned by Assets and shared by
+// every entity playing it
+struct AnimationDef
+{
+    AssetId id = NO_ASSET;
+    AssetId texture = NO_ASSET;
+    std::string name = "none";
+    size_t frameCount = 1; // total number of frames of animation
+    size_t speed = 1; // the speed to play this animation
+    Vec2 size = { 1, 1 }; // size of the animation frame
+};
+
+// an entity's playback of a shared AnimationDef: just the definition
+// and the current frame, so it is cheap to copy and to switch
 class Animation
 {
-    sf::Sprite m_sprite;
-    size_t m_frameCount = 1; // total number of frames of animation
+    const AnimationDef* m_def;
     size_t m_currentFrame = 0; // the current frame of animation being played
-    size_t m_speed = 1; // the speed to play this animation
-    Vec2 m_size = { 1, 1 }; // size of the animation frame
-    std::string m_name = "none";
 
     public:
 
     Animation();
-    Animation(const std::string& name, const sf::Texture& t);
-    Animation(
-        const std::string& name,
-        const sf::Texture& t,
-        size_t frameCount,
-        size_t speed
-    );
+    Animation(const AnimationDef& def);
 
     void update();
     bool hasEnded() const;
+    AssetId id() const;
+    AssetId texture() const;
     const std::string& getName() const;
     const Vec2& getSize() const;
-    sf::Sprite& getSprite();
+    sf::IntRect getTextureRect() const;
 };
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// layout of a baked asset pack (.kpack), all integers in native byte order
+//
+//   PackHeader
+//   PackTexture[textureCount]
+//   PackAnimation[animationCount]
+//   PackFont[fontCount]
+//   data: RGBA pixels of every texture and the raw font files,
+//         each blob 16 byte aligned and addressed by its file offset
+//
+// names are fixed size and zero terminated, so the index is used straight
+// from the mapped file without any parsing
+const size_t PACK_NAME_SIZE = 32;
+const std::uint32_t PACK_VERSION = 1;
+
+struct PackHeader
+{
+    char magic[4]; // "KMPK"
+    std::uint32_t version;
+    std::uint32_t textureCount;
+    std::uint32_t animationCount;
+    std::uint32_t fontCount;
+    std::uint32_t reserved;
+};
+
+struct PackTexture
+{
+    char name[PACK_NAME_SIZE];
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint64_t offset; // of width * height * 4 bytes of pixels
+};
+
+struct PackAnimation
+{
+    char name[PACK_NAME_SIZE];
+    std::uint32_t texture; // index into the texture table
+    std::uint32_t frames;
+    std::uint32_t speed;
+    std::uint32_t reserved;
+};
+
+struct PackFont
+{
+    char name[PACK_NAME_SIZE];
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+class AssetPack
+{
+    MappedFile m_file;
+    const PackHeader* m_header = nullptr;
+    const PackTexture* m_textures = nullptr;
+    const PackAnimation* m_animations = nullptr;
+    const PackFont* m_fonts = nullptr;
+
+    public:
+
+    // what goes into a pack, already decoded
+    struct TextureSource
+    {
+        std::string name;
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        const std::uint8_t* pixels = nullptr;
+    };
+
+    struct AnimationSource
+    {
+        std::string name;
+        std::uint32_t texture = 0;
+        std::uint32_t frames = 1;
+        std::uint32_t speed = 0;
+    };
+
+    struct FontSource
+    {
+        std::string name;
+        std::vector<char> data;
+    };
+
+    static bool write(
+        const std::string& path,
+        const std::vector<TextureSource>& textures,
+        const std::vector<AnimationSource>& animations,
+        const std::vector<FontSource>& fonts
+    );
+
+    // map a pack and check its header, that every name is terminated and
+    // that every blob is in the file
+    bool open(const std::string& path);
+
+    size_t textureCount() const;
+    size_t animationCount() const;
+    size_t fontCount() const;
+
+    const PackTexture& texture(size_t index) const;
+    const PackAnimation& animation(size_t index) const;
+    const PackFont& font(size_t index) const;
+
+    const std::uint8_t* pixels(const PackTexture& texture) const;
+    const void* fontData(const PackFont& font) const;
+};
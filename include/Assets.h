@@ -1,27 +1,157 @@
 #pragma once
 
 #include "Animation.h"
+#include "AssetPack.h"
+#include "LoadProfiler.h"
 #include "SFML/Graphics/Font.hpp"
+#include "SFML/Graphics/Image.hpp"
 #include "SFML/Graphics/Texture.hpp"
+#include <deque>
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
+
+// everything an assets config file asks for, before anything is loaded
+struct AssetManifest
+{
+    struct Entry
+    {
+        std::string name;
+        std::string path;
+    };
+
+    struct AnimationEntry
+    {
+        std::string name;
+        std::string texture;
+        int frames = 1;
+        int speed = 0;
+    };
+
+    std::vector<Entry> fonts;
+    std::vector<Entry> textures;
+    std::vector<AnimationEntry> animations;
+};
 
 class Assets
 {
-    std::map<std::string, sf::Texture> m_textures;        
-    std::map<std::string, Animation> m_animations;
+    struct ImageRequest
+    {
+        std::string name;
+        std::string path;
+        sf::Image image;
+        bool loaded = false;
+        double seconds = 0; // decode time
+        size_t fileBytes = 0;
+    };
+
+    struct TextureEntry
+    {
+        std::string name;
+        std::string path; // png to load it from, if any
+        size_t packIndex = NO_ASSET; // entry in m_pack to load it from, if any
+        std::unique_ptr<sf::Texture> texture; // null while not resident
+        sf::Vector2u size; // 0 until known
+        size_t lastUsed = 0; // m_useClock of the last require() that needed it
+    };
+
+    // textures and animation definitions are stored densely by id
+    // names are only looked up while loading
+    std::vector<TextureEntry> m_textures;
+    std::map<std::string, AssetId> m_textureIds;
+    std::deque<AnimationDef> m_animations; // deque keeps defs at a stable address
+    std::map<std::string, AssetId> m_animationIds;
     std::map<std::string, sf::Font> m_fonts;
+    std::map<std::string, std::string> m_fontPaths; // only fonts loaded from files
+    std::string m_manifestPath;
+
+    // fonts loaded from a pack read straight from its mapping,
+    // so the pack has to stay open as long as the fonts are used
+    std::shared_ptr<AssetPack> m_pack;
+
+    // residency: with lazy loading textures are only loaded by require(),
+    // and the least recently required ones are evicted over the budget
+    bool m_lazy = false;
+    bool m_metadataOnly = false;
+    size_t m_textureBudget = 0; // bytes, 0 means no limit
+    size_t m_residentBytes = 0;
+    size_t m_useClock = 0;
+
+    LoadProfiler* m_profiler = nullptr;
 
+    // returns the number of threads that decoded at least one image
+    static size_t decodeImages(std::vector<ImageRequest>& requests);
+    static bool readImageSize(const std::string& path, sf::Vector2u& size);
+    static std::vector<ImageRequest> decodeManifestImages(const AssetManifest& manifest);
+
+    AssetId declareTexture(const std::string& name);
+    void setTextureSize(AssetId id, const sf::Vector2u& size);
+    void makeResident(AssetId id, sf::Texture& texture);
+    void loadTextures(const std::vector<AssetId>& ids);
+    void evict(AssetId id);
+    void trim();
+    void profile(LoadPhase phase, const std::string& name, double seconds, size_t bytes);
+    bool reloadTexture(AssetId id);
+    void reloadManifest();
 
     public:
 
-    void addTexture(const std::string& name, const std::string& path);
-    void addAnimation(const std::string& name, Animation animation);
+    // adding an existing name replaces it in place and keeps its id
+    AssetId addTexture(const std::string& name, const std::string& path);
+    AssetId addTexture(const std::string& name, sf::Texture&& texture);
+    AssetId addAnimation(
+        const std::string& name,
+        const std::string& texture,
+        size_t frameCount,
+        size_t speed
+    );
     void addFont(const std::string& name, const std::string& path);
 
+    AssetId getTextureId(const std::string& name) const;
+    AssetId getAnimationId(const std::string& name) const;
+
+    const sf::Texture& getTexture(AssetId id) const;
     const sf::Texture& getTexture(const std::string& name) const;
-    const Animation& getAnimation(const std::string& name) const;
+    const AnimationDef& getAnimationDef(AssetId id) const;
+    Animation getAnimation(AssetId id) const;
+    Animation getAnimation(const std::string& name) const;
     const sf::Font& getFont(const std::string& name) const;
     
+    // loading time of every asset is recorded here, if set
+    void setProfiler(LoadProfiler* profiler);
+
+    // lazy loading only registers textures in loadFromFile / loadFromPack
+    void setLazyLoading(bool lazy);
+    void setTextureBudget(size_t bytes);
+
+    // textures only get their size, from the png header or the pack
+    // index; nothing is decoded or uploaded, so no GL context is needed
+    // and getTexture() must not be called (headless simulation)
+    void setMetadataOnly(bool metadataOnly);
+    bool isMetadataOnly() const;
+
+    // make the textures of these animations resident, then evict the least
+    // recently required other textures until the budget is met
+    void require(const std::vector<AssetId>& animations);
+    bool isResident(AssetId texture) const;
+    size_t residentBytes() const;
+
+    // hot reload: the assets config and every png and font it refers to
+    // changed textures are replaced in place, so ids and pointers stay valid
+    std::vector<std::string> sourceFiles() const;
+    bool isManifest(const std::string& path) const;
+    bool reload(const std::string& path); // false if nothing uses the file
+
+    // false, after printing where, if the config does not parse
+    static bool readManifest(const std::string& path, AssetManifest& manifest);
     void loadFromFile(const std::string& path);
+
+    // load a pack made by bakePack: no config parsing and no png decoding,
+    // pixels are uploaded straight from the mapped file
+    // texture sizes are in the pack index, so nothing is uploaded until needed
+    void loadFromPack(const std::string& path);
+
+    // decode everything an assets config refers to into a single pack file
+    static bool bakePack(const std::string& configPath, const std::string& packPath);
 };
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Vec2.h"
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+// decorations of a level baked into static vertex meshes, one per texture
+// the whole layer is drawn with a single offset per frame, which scrolls
+// it slower than the camera (parallax) or exactly with it (parallax 1)
+class BackgroundLayer
+{
+    struct Mesh
+    {
+        const sf::Texture* texture = nullptr;
+        std::vector<sf::Vertex> vertices;
+    };
+
+    std::string m_name;
+    float m_parallax = 1;
+    std::vector<Mesh> m_meshes;
+    size_t m_quadCount = 0;
+
+    public:
+
+    BackgroundLayer(const std::string& name, float parallax);
+
+    // bake one decoration into the mesh of its texture
+    void add(
+        const sf::Texture* texture,
+        const sf::IntRect& rect,
+        const Vec2& pos,
+        const Vec2& scale
+    );
+
+    // offset of the layer when the left edge of the view is at cameraX
+    sf::Vector2f offset(float cameraX) const;
+
+    void draw(sf::RenderTarget& target, const sf::Vector2f& offset) const;
+
+    const std::string& name() const;
+    float parallax() const;
+    size_t meshCount() const;
+    size_t quadCount() const;
+};
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Animation.h"
+#include "RenderQueue.h"
+
+#include <cstdint>
 
 // set a flag: flag |= (int)PlayerState
 // unset a flag: flag &= ~(int)PlayerState
@@ -76,9 +79,10 @@ class CAnimation : public Component
     public:
         Animation animation;
         bool repeat = false;
+        RenderLayer layer = RenderLayer::ENTITY; // fixed when the entity is made
         CAnimation() {}
-        CAnimation(const Animation& animation, bool r) 
-        : animation(animation), repeat(r) {}
+        CAnimation(const Animation& animation, bool r, RenderLayer l = RenderLayer::ENTITY) 
+        : animation(animation), repeat(r), layer(l) {}
 };
 
 class CGravity : public Component
@@ -89,6 +93,16 @@ class CGravity : public Component
         CGravity(float g) : gravity(g) {}
 };
 
+// a tile that belongs to a streamed level chunk
+class CChunk : public Component
+{
+    public:
+        size_t chunk = 0;
+        std::uint32_t record = 0; // index of the tile in the level
+        CChunk() {}
+        CChunk(size_t c, std::uint32_t r) : chunk(c), record(r) {}
+};
+
 class CState : public Component
 {
     public:
@@ -7,6 +7,21 @@
 typedef std::vector<std::shared_ptr<Entity>> EntityVec;
 typedef std::map<std::string, EntityVec> EntityMap;
 
+// the state of every live entity, copied out flat so it can be put back
+// without rebuilding the world from its source
+struct EntitySnapshot
+{
+    struct Record
+    {
+        size_t id;
+        std::string tag;
+        ComponentTuple components;
+    };
+
+    std::vector<Record> entities;
+    size_t totalEntities = 0;
+};
+
 class EntityManager
 {
     EntityVec m_entities; // all entities
@@ -24,6 +39,14 @@ class EntityManager
 
         std::shared_ptr<Entity> addEntity(const std::string& tag);
 
+        // make room for this many more entities before adding them in bulk
+        void reserve(size_t count);
+
+        // entities waiting to be added are included, restoring puts the
+        // snapshot's entities straight into place in the same order
+        EntitySnapshot snapshot() const;
+        void restore(const EntitySnapshot& snapshot);
+
         const EntityVec& getEntities();
         const EntityVec& getEntities(const std::string& tag);
         const std::map<std::string, EntityVec>& getEntityMap();
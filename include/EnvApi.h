@@ -0,0 +1,81 @@
+#pragma once
+
+// C interface for driving headless levels from other programs, e.g. an
+// agent training harness: no window and no textures; several copies of
+// a level can be stepped at once
+// observations are written straight into the caller's buffer without
+// allocating; a step can allocate, as the game does when it spawns
+// bullets, coins or debris, activates chunks or restarts after a fall,
+// and handing the copies to the worker threads allocates a task each
+//
+// an environment handle holds `count` independent copies of one level,
+// every call works on all of them, with per copy arguments laid out
+// one after the other
+//
+// calls with invalid arguments return -1 and change nothing; an assets
+// config that does not load is printed and ends the process, like it
+// does in the game
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define KM_API __declspec(dllexport)
+#else
+#define KM_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// bits of a step's action mask, an action is held for as long as its
+// bit stays set
+enum {
+    KM_ACTION_LEFT = 1 << 0,
+    KM_ACTION_RIGHT = 1 << 1,
+    KM_ACTION_JUMP = 1 << 2,
+    KM_ACTION_DOWN = 1 << 3,
+    KM_ACTION_SHOOT = 1 << 4
+};
+
+// observation of one copy, km_observation_size() floats:
+//   KM_OBS_PLAYER values: x, y (grid cells, y up), velocity x, velocity y,
+//     can jump (0 / 1), facing (1 right, -1 left), score, frame
+//   KM_OBS_GRID_WIDTH * KM_OBS_GRID_HEIGHT tile occupancy (0 / 1) of the
+//     cells around the player, row major from the top left
+//   KM_OBS_ENTITIES entries of: kind (1 bullet, 2 coin, 0 unused slot),
+//     x and y offset from the player in grid cells
+#define KM_OBS_PLAYER 8
+#define KM_OBS_GRID_WIDTH 20
+#define KM_OBS_GRID_HEIGHT 12
+#define KM_OBS_ENTITIES 16
+
+typedef struct km_env km_env;
+
+// threads steps copies in parallel, 0 uses one per hardware thread
+// returns NULL without assets or level, if count is not positive or if
+// the level cannot be loaded
+KM_API km_env* km_create_env(const char* assets, const char* level, int count, int threads);
+KM_API void km_destroy_env(km_env* env);
+// returns -1 without env
+KM_API int km_env_count(const km_env* env);
+KM_API size_t km_observation_size(void);
+
+// back to the start of the level and no action held, index -1 for all
+// returns 0, or -1 if index is not -1 or a copy
+KM_API int km_reset(km_env* env, int index);
+
+// one tick of every copy, actions holds one mask per copy
+// rewards (score gained) and dones (fell into a hole, the copy restarted
+// by itself) are written per copy if not null
+// returns 0, or -1 without env or actions
+KM_API int km_step(km_env* env, const uint32_t* actions, float* rewards, uint8_t* dones);
+
+// count * km_observation_size() floats
+// returns 0, or -1 without env or buffer
+KM_API int km_observe(km_env* env, float* buffer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// reports files that were written in a set of watched directories
+// uses inotify on linux and ReadDirectoryChangesW on windows, on other
+// platforms nothing is ever reported and hot reload does nothing
+// poll() never blocks, so it can be called once per frame
+class FileWatcher
+{
+#if defined(__linux__)
+    int m_fd = -1;
+    bool m_started = false; // inotify is set up by the first watch()
+    std::map<int, std::string> m_dirs; // watch descriptor to directory
+#elif defined(_WIN32)
+    struct Directory; // keeps windows.h out of this header
+    std::vector<std::unique_ptr<Directory>> m_dirs;
+#endif
+
+    public:
+
+    FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+    ~FileWatcher();
+
+    // directories already watched are ignored
+    bool watch(const std::string& dir);
+
+    // canonical paths of files finished being written since the last
+    // poll, each listed once
+    std::vector<std::string> poll();
+};
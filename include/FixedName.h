@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+// copy a name into a fixed size, zero terminated field of a file format,
+// zeroing the rest of the field; a name that does not fit is cut short
+// and false is returned, so writers that need it whole can refuse it
+template<size_t N>
+bool copyName(char (&field)[N], std::string_view name) {
+    size_t length = name.size() < N ? name.size() : N - 1;
+    std::memset(field, 0, N);
+    std::memcpy(field, name.data(), length);
+    return name.size() < N;
+}
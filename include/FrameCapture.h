@@ -0,0 +1,89 @@
+#pragma once
+
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum struct CaptureFormat {
+    PNG,
+    RAW // headerless 8 bit RGBA, top row first, size in info.txt
+};
+
+// reads finished frames into a ring of pixel pack buffers, which the GPU
+// fills in the background; each one is copied out a frame later into a
+// preallocated buffer that a background thread encodes and writes, so
+// saving a screenshot or recording a session never stalls the game loop
+// when every buffer is busy the captured frame is dropped, never the
+// gameplay frame
+// the encoder thread is only started once a frame is captured
+class FrameCapture
+{
+    struct Slot
+    {
+        std::vector<unsigned char> pixels;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        std::string path;
+    };
+
+    // a read into a pixel pack buffer, mapped once its frame is over
+    struct Readback
+    {
+        size_t slot = 0;
+        size_t buffer = 0;
+        size_t frame = 0;
+    };
+
+    std::vector<Slot> m_slots;
+    // only touched on the thread that draws
+    std::vector<unsigned int> m_pixelBuffers; // GL names
+    std::vector<size_t> m_pixelBufferSizes;
+    std::vector<size_t> m_freePixelBuffers;
+    std::deque<Readback> m_readbacks;
+    size_t m_frame = 0;
+    bool m_pixelBuffersTried = false;
+    std::vector<size_t> m_freeSlots;
+    std::deque<size_t> m_pending; // filled slots waiting to be encoded
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_encoder;
+    bool m_running = true;
+
+    std::atomic<bool> m_screenshotRequested = false;
+    std::atomic<bool> m_recording = false;
+    std::string m_recordDir;
+    CaptureFormat m_recordFormat = CaptureFormat::PNG;
+    size_t m_recordedFrames = 0;
+    size_t m_droppedFrames = 0;
+
+    bool capture(sf::RenderTarget& target, const std::string& path);
+    bool createPixelBuffers();
+    void collect(bool all);
+    void queue(size_t index);
+    void encode(Slot& slot);
+    void run();
+
+    public:
+
+    FrameCapture(size_t slotCount = 8);
+    ~FrameCapture();
+
+    // saved after the next frame is drawn
+    void requestScreenshot();
+
+    void startRecording(const std::string& dir, CaptureFormat format);
+    void stopRecording();
+    bool isRecording() const;
+
+    // call from the thread that owns the target's GL context, after the
+    // frame was drawn and before it is displayed
+    void onFrameDrawn(sf::RenderTarget& target);
+    // copy out the reads still in flight and free the pixel buffers, on
+    // the same thread and while the context still exists
+    void finish(sf::RenderTarget& target);
+};
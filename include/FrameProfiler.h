@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "TraceRecorder.h"
+
+// debug builds always profile, release builds only when built with
+// KM_PROFILE; a release build with only KM_TRACE times the scopes as
+// spans of a recorded trace, at the cost of a check whether one is being
+// recorded, and with neither flag the scopes are compiled out
+#if !defined(KM_PROFILE) && !defined(NDEBUG)
+#define KM_PROFILE
+#endif
+// the profiler's scopes are trace spans as well
+#if defined(KM_PROFILE) && !defined(KM_TRACE)
+#define KM_TRACE
+#endif
+
+#define KM_PROFILE_CONCAT_(a, b) a##b
+#define KM_PROFILE_CONCAT(a, b) KM_PROFILE_CONCAT_(a, b)
+
+#ifdef KM_PROFILE
+// times the rest of the enclosing block into the current frame
+#define PROFILE_SCOPE(section) \
+    ProfileScope KM_PROFILE_CONCAT(profileScope, __LINE__)(ProfileSection::section)
+// closes the current frame, once per game loop iteration
+#define PROFILE_END_FRAME() FrameProfiler::instance().endFrame()
+#elif defined(KM_TRACE)
+#define PROFILE_SCOPE(section) \
+    TraceScope KM_PROFILE_CONCAT(profileScope, __LINE__)(ProfileSection::section)
+#define PROFILE_END_FRAME()
+#else
+#define PROFILE_SCOPE(section)
+#define PROFILE_END_FRAME()
+#endif
+
+// parts of a frame that are timed
+enum struct ProfileSection {
+    FRAME, // one whole iteration of the game loop
+    USER_INPUT,
+    ENTITY_UPDATE,
+    MOVEMENT,
+    LIFESPAN,
+    COLLISION,
+    STREAMING,
+    ANIMATION,
+    RENDER, // filling the frame, sRender
+    DRAW, // turning the frame into draw calls
+    DISPLAY, // swapping buffers, waits for vsync / the frame limiter
+    COUNT
+};
+
+// per section time of the last WINDOW frames, for min / avg / p99
+// sections may be timed from any thread (drawing happens on the render
+// thread when there is one) and several times a frame, the times are
+// summed into the frame that is open when they finish
+// threads that run scenes of their own, like pool workers stepping many
+// instances side by side, are switched off with setThreadProfiler so
+// their timings are not mixed into the engine's frames
+class FrameProfiler
+{
+    public:
+
+    static constexpr size_t SECTION_COUNT = (size_t)ProfileSection::COUNT;
+    static constexpr size_t WINDOW = 120; // frames
+
+    struct Stats
+    {
+        double min = 0; // milliseconds
+        double avg = 0;
+        double p99 = 0;
+    };
+
+    private:
+
+    std::array<std::atomic<std::int64_t>, SECTION_COUNT> m_current = {}; // ns
+    std::array<std::array<std::int64_t, WINDOW>, SECTION_COUNT> m_samples = {};
+    size_t m_frames = 0;
+
+    public:
+
+    static FrameProfiler& instance();
+    static const char* sectionName(ProfileSection section);
+
+    // what the calling thread's scopes add to, instance() unless changed,
+    // nullptr times nothing
+    static FrameProfiler* threadProfiler();
+    static void setThreadProfiler(FrameProfiler* profiler);
+
+    void add(ProfileSection section, std::int64_t nanoseconds);
+    void endFrame();
+    size_t frames() const; // frames in the window so far
+    Stats stats(ProfileSection section) const;
+};
+
+// the same scopes are the spans of a recorded trace
+inline void traceSection(
+    ProfileSection section,
+    std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end
+) {
+    TraceRecorder::instance().span(
+        section == ProfileSection::FRAME ? "frame" : "system",
+        FrameProfiler::sectionName(section), start, end
+    );
+}
+
+class ProfileScope
+{
+    ProfileSection m_section;
+    FrameProfiler* m_profiler;
+    std::chrono::steady_clock::time_point m_start;
+
+    public:
+
+    ProfileScope(ProfileSection section)
+        : m_section(section)
+        , m_profiler(FrameProfiler::threadProfiler())
+        , m_start(std::chrono::steady_clock::now())
+    {}
+
+    ~ProfileScope() {
+        auto end = std::chrono::steady_clock::now();
+        if (m_profiler) {
+            m_profiler->add(
+                m_section,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_start).count()
+            );
+        }
+        if (TraceRecorder::instance().isRecording()) {
+            traceSection(m_section, m_start, end);
+        }
+    }
+};
+
+// a scope that is only timed while a trace is recorded, for KM_TRACE
+// builds without the profiler
+class TraceScope
+{
+    ProfileSection m_section;
+    bool m_recording;
+    std::chrono::steady_clock::time_point m_start;
+
+    public:
+
+    TraceScope(ProfileSection section)
+        : m_section(section)
+        , m_recording(TraceRecorder::instance().isRecording())
+    {
+        if (m_recording) {
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~TraceScope() {
+        if (m_recording) {
+            traceSection(m_section, m_start, std::chrono::steady_clock::now());
+        }
+    }
+};
@@ -1,8 +1,16 @@
 #pragma once
 
+#include "SFML/Graphics/RenderTexture.hpp"
 #include "SFML/Graphics/RenderWindow.hpp"
 #include "Scene.h"
 #include "Assets.h"
+#include "FileWatcher.h"
+#include "FrameCapture.h"
+#include "InputRecorder.h"
+#include "InputScript.h"
+#include "LoadProfiler.h"
+#include "RenderFrame.h"
+#include "RenderThread.h"
 
 #include <memory>
 #include <map>
@@ -10,27 +18,113 @@
 class Scene;
 typedef std::map<std::string, std::shared_ptr<Scene>> SceneMap;
 
+// where frames end up
+enum struct RenderBackend {
+    WINDOW, // a real window, the normal game
+    TEXTURE, // an offscreen sf::RenderTexture, no window needed
+    RECORD // null renderer, only counts what would have been drawn
+};
+
+struct EngineConfig
+{
+    RenderBackend backend = RenderBackend::WINDOW;
+
+    // draw and present frames on a separate thread, so waiting for
+    // vsync does not block the simulation (window backend only)
+    bool renderThread = false;
+
+    std::string level; // start straight into this level instead of the menu
+    // false loads neither, for programs that make and step their own
+    // scenes without run(), like the EnvApi
+    bool startScene = true;
+    size_t frames = 0; // stop after this many frames, 0 runs until quit
+
+    // run the level's systems flat out for `frames` ticks with
+    // Scene::simulate and report ticks per second; nothing is drawn
+    bool simulate = false;
+    // scripted or recorded actions, sent at their tick instead of the
+    // keyboard's; a recording also picks the level and the run length
+    std::string inputs;
+    std::string recordInputs; // log every action sent to the scene here
+
+    // with simulate, run this many independent copies of the level on a
+    // thread pool of `jobs` workers (0: one per hardware thread)
+    size_t instances = 1;
+    size_t jobs = 0;
+
+    // offscreen frame dumps and golden image comparison (texture backend)
+    size_t dumpEvery = 0; // save every Nth frame, 0 disables dumping
+    std::string dumpDir = "frames";
+    std::string goldenDir; // compare dumped frames against images in here
+    int tolerance = 0; // allowed difference per color channel
+
+    // only load the textures a level uses, evicting the least recently
+    // used ones once more than textureBudget bytes are resident (0: no limit)
+    bool lazyAssets = true;
+    size_t textureBudget = 0;
+
+    // report where startup time went when the game exits
+    bool loadProfile = false;
+    std::string loadProfileJson; // also write every load event here
+
+    // reload assets and levels when their files change on disk
+    bool hotReload = false;
+
+    // record every drawn frame into this directory from the start
+    std::string captureDir;
+    CaptureFormat captureFormat = CaptureFormat::PNG;
+
+    // record frame, system and asset load timings plus entity and draw
+    // call counters, written here as Chrome trace JSON on exit or F12
+    std::string trace;
+};
+
 class GameEngine
 {
     protected:
 
     sf::RenderWindow m_window;
+    std::unique_ptr<sf::RenderTexture> m_renderTexture;
+    sf::Vector2u m_size = { 1280, 768 };
     Assets m_assets;
     std::string m_currentScene;
     SceneMap m_sceneMap;
     size_t m_simulationSpeed = 1;
     bool m_running = true;
+    EngineConfig m_config;
+    RenderFrame m_frame; // frame being built when there is no render thread
+    std::unique_ptr<RenderThread> m_renderThread;
+    FrameCapture m_capture;
+    FileWatcher m_watcher;
+    LoadProfiler m_loadProfiler;
+    InputScript m_inputs;
+    bool m_scripted = false; // actions come from m_inputs
+    InputRecorder m_inputRecorder;
+    RenderStats m_renderStats;
+    size_t m_frameCount = 0;
+    size_t m_goldenFailures = 0;
+    double m_frameSeconds = 0; // time spent in update() and present()
 
     void init(const std::string& path);
     void update();
+    void present();
+    void drawFrame(RenderFrame& frame);
+    void dumpFrame();
+    bool compareWithGolden(const sf::Image& image, const std::string& fileName);
+    void printRenderStats() const;
+    void traceCounters();
+    void simulate();
+    void simulateInstances();
 
     void sUserInput();
+    void sHotReload();
 
     std::shared_ptr<Scene> currentScene();
 
     public:
 
-    GameEngine(const std::string& path);
+    GameEngine(const std::string& path, const EngineConfig& config = EngineConfig());
+    ~GameEngine();
 
     void changeScene(
         const std::string& sceneName,
@@ -40,8 +134,16 @@ class GameEngine
 
     void quit();
     void run();
+    bool isCurrentScene(const Scene* scene) const;
 
     sf::RenderWindow& window();
+    sf::Vector2u size() const;
+    RenderFrame& frame();
     const Assets& assets() const;
+    LoadProfiler& loadProfiler();
+    void requireAssets(const std::vector<AssetId>& animations);
+    void watchFile(const std::string& path); // only with hot reload in the frame loop
     bool isRunning();
+    bool isHeadless() const;
+    int exitCode() const;
 };
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Action.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// layout of an input recording, all integers in native byte order
+//
+//   InputHeader
+//   char[INPUT_NAME_SIZE] per action, the names events refer to
+//   events, eventCount of them:
+//     varint  ticks since the previous event (the first: since tick 0)
+//     uint8   action index << 1, plus 1 for START
+//
+// only changes of key state are stored, a held key costs nothing per
+// tick, and a whole session is usually a few KB
+const size_t INPUT_NAME_SIZE = 32;
+const size_t INPUT_LEVEL_SIZE = 256;
+const std::uint32_t INPUT_VERSION = 1;
+const size_t INPUT_MAX_ACTIONS = 128;
+
+struct InputHeader
+{
+    char magic[4]; // "KINP"
+    std::uint32_t version;
+    std::uint32_t tickCount; // ticks the session ran for
+    std::uint32_t eventCount;
+    std::uint32_t actionCount;
+    char level[INPUT_LEVEL_SIZE]; // the level played
+};
+
+// logs the actions sent to the scene each tick, replayed by loading the
+// file into an InputScript
+class InputRecorder
+{
+    std::string m_path;
+    std::string m_level;
+    std::vector<std::string> m_names; // index is the action's id in the file
+    std::vector<unsigned char> m_events; // encoded, written out by stop()
+    size_t m_eventCount = 0;
+    size_t m_tick = 0;
+    size_t m_lastEventTick = 0;
+    bool m_recording = false;
+
+    public:
+
+    void start(const std::string& path, const std::string& level);
+    bool isRecording() const;
+
+    // an action sent to the scene before the current tick is stepped
+    void record(const Action& action);
+    void endTick();
+
+    // writes the file, false if it could not be
+    bool stop();
+};
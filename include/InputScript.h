@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Action.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Scene;
+
+// actions to send at given ticks, either written by hand or recorded
+// text scripts have one action per line:
+//   <tick> <action name> <START|END>
+// e.g. "0 RIGHT START" then "40 JUMP START" and "52 JUMP END"
+// lines may come in any order, actions of the same tick keep theirs
+// recordings made by InputRecorder are recognised by their header
+class InputScript
+{
+    std::vector<std::pair<size_t, Action>> m_actions; // sorted by tick
+    size_t m_next = 0;
+    size_t m_tickCount = 0;
+    std::string m_level;
+
+    bool readText(const std::string& path, const char* data, size_t size);
+    bool readRecording(const std::string& path, const unsigned char* data, size_t size);
+
+    public:
+
+    bool load(const std::string& path);
+
+    // ticks the recorded session ran for, 0 for text scripts
+    size_t tickCount() const;
+    // the level a recording was made in, empty for text scripts
+    const std::string& level() const;
+
+    // start over from tick 0
+    void rewind();
+
+    // sends every action of this tick to the scene, ticks must be
+    // applied in increasing order
+    void apply(Scene& scene, size_t tick);
+
+    size_t size() const;
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// text as a quoted JSON string, with quotes, backslashes and control
+// characters escaped; shared by the load profile and trace writers
+std::string jsonString(std::string_view text);
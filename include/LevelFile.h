@@ -0,0 +1,101 @@
+#pragma once
+
+#include "LoadProfiler.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// layout of a compiled level (.klvl), all integers in native byte order
+//
+//   LevelHeader
+//   LevelLayer[layerCount]
+//   LevelType[typeCount]
+//   LevelTile[tileCount], sorted by x
+//
+// every tile refers to a type, so a level with 100k tiles stores each
+// animation name once and loads without parsing a single token
+// tiles being sorted lets a streamer find any column range by binary search
+const size_t LEVEL_NAME_SIZE = 32;
+const std::uint32_t LEVEL_VERSION = 2;
+
+enum struct LevelTileKind : std::uint32_t {
+    TILE, // a colliding entity
+    DECORATION // baked into a background layer
+};
+
+struct LevelPlayer
+{
+    float x, y, cx, cy, speed, jump, maxSpeed, gravity;
+    char weapon[LEVEL_NAME_SIZE];
+};
+
+struct LevelHeader
+{
+    char magic[4]; // "KLVL"
+    std::uint32_t version;
+    std::uint32_t layerCount;
+    std::uint32_t typeCount;
+    std::uint32_t tileCount;
+    std::uint32_t hasPlayer;
+    LevelPlayer player;
+};
+
+struct LevelLayer
+{
+    char name[LEVEL_NAME_SIZE];
+    float parallax;
+    std::uint32_t reserved;
+};
+
+struct LevelType
+{
+    char animation[LEVEL_NAME_SIZE];
+    LevelTileKind kind;
+    std::uint32_t layer; // background layer of a decoration
+};
+
+struct LevelTile
+{
+    std::uint32_t type; // index into the type table
+    float x, y; // grid coordinates
+};
+
+// a level either read from a text file or mapped from a compiled one,
+// both are used through the same tables
+class LevelFile
+{
+    MappedFile m_file;
+    const LevelHeader* m_header = nullptr;
+    const LevelLayer* m_layers = nullptr;
+    const LevelType* m_types = nullptr;
+    const LevelTile* m_tiles = nullptr;
+
+    // storage for levels read from text
+    LevelHeader m_textHeader;
+    std::vector<LevelLayer> m_textLayers;
+    std::vector<LevelType> m_textTypes;
+    std::vector<LevelTile> m_textTiles;
+
+    bool readText(const std::string& path, LoadProfiler* profiler);
+    bool mapBinary(const std::string& path);
+
+    public:
+
+    // .klvl files are mapped, anything else is read as a text level
+    // parse times go to the profiler, if given
+    bool open(const std::string& path, LoadProfiler* profiler = nullptr);
+    bool write(const std::string& path) const;
+
+    // text level to compiled level
+    static bool convert(const std::string& textPath, const std::string& binaryPath);
+
+    size_t layerCount() const;
+    size_t typeCount() const;
+    size_t tileCount() const;
+    const LevelLayer& layer(size_t index) const;
+    const LevelType& type(size_t index) const;
+    const LevelTile* tiles() const;
+    const LevelPlayer* player() const; // null if the level has no player
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// knobs of a generated level, probabilities are per column
+struct GeneratorConfig
+{
+    std::uint64_t seed = 1;
+    size_t length = 200; // columns, each holds one to a few tiles
+    float tileDensity = 0.2f; // chance a column starts a row of floating blocks
+    float questionRatio = 0.3f; // share of floating blocks that are question blocks
+    float decorationDensity = 0.1f; // chance a column starts a cloud or a hill
+    float pipeFrequency = 0.05f; // chance a column starts a pipe
+    float holeFrequency = 0.03f; // chance a column starts a hole in the ground
+};
+
+// writes seeded random levels in the text level format, the same seed
+// and config always give the same file on every platform, so generated
+// levels can serve as the workload of benchmarks
+class LevelGenerator
+{
+    public:
+
+    struct Counts
+    {
+        size_t tiles = 0;
+        size_t decorations = 0;
+    };
+
+    static bool write(const std::string& path, const GeneratorConfig& config, Counts& counts);
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "LevelFile.h"
+#include "LoadProfiler.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// what happened to a tile, kept after its chunk is unloaded
+enum struct TileChange : std::uint8_t {
+    NONE,
+    BROKEN, // a brick that was smashed
+    HIT // a question block whose coin was taken
+};
+
+// a colliding tile of a chunk, decorations are not streamed
+struct ChunkTile
+{
+    std::uint32_t record; // index of the tile in the level
+    std::uint32_t type;
+    float x, y;
+};
+
+// splits a level into chunks of CHUNK_WIDTH grid columns and loads their
+// tiles on a background thread, so a level can be any length while only
+// the chunks around the camera are in memory
+class LevelStreamer
+{
+    enum struct ChunkState {
+        UNLOADED,
+        QUEUED,
+        LOADING,
+        LOADED
+    };
+
+    struct Chunk
+    {
+        ChunkState state = ChunkState::UNLOADED;
+        std::vector<ChunkTile> tiles;
+    };
+
+    std::unique_ptr<LevelFile> m_level;
+    std::vector<Chunk> m_chunks;
+    std::deque<size_t> m_queue;
+    std::vector<size_t> m_resident; // chunks that are not UNLOADED
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+    bool m_running = false;
+
+    // only tiles that changed are stored, a few bytes each
+    std::map<std::uint32_t, TileChange> m_changes;
+
+    void load(size_t chunk, std::vector<ChunkTile>& tiles) const;
+    void run();
+
+    public:
+
+    static const int CHUNK_WIDTH = 16;
+
+    LevelStreamer();
+    LevelStreamer(const LevelStreamer&) = delete;
+    LevelStreamer& operator=(const LevelStreamer&) = delete;
+    ~LevelStreamer();
+
+    // starts the loading thread, changes of a previous level are dropped
+    bool open(const std::string& path, LoadProfiler* profiler = nullptr);
+    void close();
+
+    const LevelFile& level() const;
+    size_t chunkCount() const;
+    size_t chunkOf(float gridX) const;
+
+    // load chunks first..last in the background, in that order, and
+    // unload every other chunk; only the resident chunks and the window
+    // are visited, so call it when the window moves, not every tick
+    void prefetch(size_t first, size_t last);
+
+    // tiles of a chunk, waiting for it if it is not loaded yet
+    // valid until the next prefetch()
+    const std::vector<ChunkTile>& tiles(size_t chunk);
+
+    void setChange(std::uint32_t record, TileChange change);
+    TileChange change(std::uint32_t record) const;
+    // every tile back the way the level file has it
+    void clearChanges();
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// what part of startup a load event belongs to
+enum struct LoadPhase {
+    CONFIG, // reading the assets config
+    FONT,
+    DECODE, // png to pixels, on worker threads
+    METADATA, // image sizes read from file headers, nothing decoded
+    UPLOAD, // pixels to GL textures
+    WINDOW, // creating the window or offscreen target
+    LEVEL_PARSE, // reading level lines, one event per line kind
+    LEVEL_BUILD // creating entities and baking background layers
+};
+
+struct LoadEvent
+{
+    LoadPhase phase;
+    std::string name;
+    double seconds = 0;
+    size_t bytes = 0;
+    size_t count = 1; // level lines of this kind
+};
+
+// collects where startup time goes, so we know whether png decoding,
+// GL uploads, fonts or window creation dominate before optimising
+// events may be added from any thread, e.g. a loading scene's worker
+// or levels loaded by parallel simulation runs
+class LoadProfiler
+{
+    std::vector<LoadEvent> m_events;
+    double m_initSeconds = 0;
+    size_t m_decodeThreads = 0; // most threads one batch of pngs was decoded on
+    std::mutex m_mutex; // guards m_events while they are added
+
+    public:
+
+    static const char* phaseName(LoadPhase phase);
+
+    void add(
+        LoadPhase phase,
+        const std::string& name,
+        double seconds,
+        size_t bytes = 0,
+        size_t count = 1
+    );
+    // threads that decoded at least one png of a batch
+    void noteDecodeThreads(size_t threads);
+    void setInitSeconds(double seconds);
+    const std::vector<LoadEvent>& events() const;
+
+    void printSummary(std::ostream& out) const;
+    bool writeJson(const std::string& path) const;
+};
+
+// seconds since construction, for timing a block of loading code
+class LoadTimer
+{
+    std::chrono::steady_clock::time_point m_start;
+
+    public:
+
+    LoadTimer();
+    double seconds() const;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// read-only memory mapping of a whole file
+// pages are only read from disk when they are first touched
+class MappedFile
+{
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+
+    public:
+
+    MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const;
+    const unsigned char* data() const;
+    size_t size() const;
+};
@@ -1,12 +1,26 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "Entity.h"
 #include "Vec2.h"
 
+// a rectangle of whole grid cells, y grows upwards like level coordinates
+struct GridRect
+{
+    int x, y;
+    int width, height;
+};
+
 class Physics
 {
     public:
+        // greedily merges solid grid cells into as few rectangles as
+        // possible: each row is cut into maximal runs, then runs with the
+        // same span in consecutive rows are stacked
+        // duplicate cells are allowed
+        static std::vector<GridRect> MergeCells(std::vector<std::pair<int, int>> cells);
+
         Vec2 GetOverlap(
             std::shared_ptr<Entity> a,
             std::shared_ptr<Entity> b
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "BackgroundLayer.h"
+#include "RenderQueue.h"
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <vector>
+
+// totals of what was drawn, used to compare render cost between runs
+struct RenderStats
+{
+    size_t frames = 0;
+    size_t commands = 0;
+    size_t batches = 0;
+    size_t lines = 0;
+    size_t texts = 0;
+};
+
+// everything needed to draw one frame, filled in by a scene's sRender
+// the frame holds copies of all state, so it can be drawn after the
+// simulation has moved on (or on another thread)
+struct RenderFrame
+{
+    sf::Color clearColor = sf::Color::Black;
+    sf::View view;
+    // baked background layers and their scroll offset, drawn first
+    std::vector<std::shared_ptr<const BackgroundLayer>> layers;
+    std::vector<sf::Vector2f> layerOffsets;
+    RenderQueue queue; // sprites of the world
+    std::vector<sf::Vertex> lines; // debug lines, pairs of vertices
+    std::vector<sf::Text> texts; // hud and debug text, drawn last
+
+    void clear();
+    void addLayer(std::shared_ptr<const BackgroundLayer> layer, const sf::Vector2f& offset);
+    void addLine(const sf::Vector2f& p1, const sf::Vector2f& p2, const sf::Color& color);
+    void draw(sf::RenderTarget& target, RenderStats& stats);
+
+    // null renderer: goes through sorting and batching and counts
+    // what would have been drawn, without touching the GPU
+    void record(RenderStats& stats);
+    void addStats(RenderStats& stats) const;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Vec2.h"
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+
+// draw layers, drawn from lowest to highest
+enum struct RenderLayer : std::uint8_t {
+    BACKGROUND = 0,
+    DECORATION = 1,
+    TILE = 2,
+    ENTITY = 3,
+    HUD = 4
+};
+
+// a single textured quad to draw
+// key bits: [63..56] layer, [55..32] texture, [31..0] depth
+struct RenderCommand
+{
+    std::uint64_t key = 0;
+    const sf::Texture* texture = nullptr;
+    sf::IntRect textureRect;
+    float transform[6] = { 1, 0, 0, 0, 1, 0 }; // 2x3 affine matrix, row major
+};
+
+class RenderQueue
+{
+    std::vector<RenderCommand> m_commands;
+    std::vector<RenderCommand> m_scratch; // radix sort ping-pong buffer
+    std::vector<sf::Vertex> m_vertices; // vertices of the batch being built
+    size_t m_lastBatchCount = 0;
+    size_t m_lastCommandCount = 0;
+
+    void sort();
+    void drawBatch(sf::RenderTarget* target, const sf::Texture* texture);
+    void flush(sf::RenderTarget* target);
+
+    public:
+
+    static std::uint64_t makeKey(
+        RenderLayer layer,
+        std::uint32_t texture,
+        std::uint32_t depth
+    );
+
+    // affine transform of a rect centered on pos, like sf::Sprite::getTransform
+    // for a sprite whose origin is the middle of its texture rect
+    static void makeTransform(
+        float out[6],
+        const sf::IntRect& rect,
+        const Vec2& pos,
+        const Vec2& scale,
+        float angle
+    );
+
+    // append the two triangles of a transformed, textured rect
+    static void appendQuad(
+        std::vector<sf::Vertex>& vertices,
+        const sf::IntRect& rect,
+        const float transform[6]
+    );
+
+    // queue a textured rect centered on pos, like a sprite whose origin
+    // is the middle of its texture rect. textureId is the texture's asset
+    // id, so commands sharing a texture sort next to each other
+    void submit(
+        RenderLayer layer,
+        std::uint32_t depth,
+        std::uint32_t textureId,
+        const sf::Texture* texture,
+        const sf::IntRect& rect,
+        const Vec2& pos,
+        const Vec2& scale,
+        float angle
+    );
+
+    // sort the queued commands, merge them into batches sharing a texture
+    // and draw them to the target. the queue is empty afterwards
+    void flush(sf::RenderTarget& target);
+
+    // same as flush, but only counts the batches instead of drawing them
+    void record();
+    void clear();
+
+    size_t size() const;
+    size_t lastBatchCount() const;
+    size_t lastCommandCount() const;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "RenderFrame.h"
+
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+typedef std::function<void(RenderFrame&)> FrameDrawFunc;
+
+// draws frames on its own thread, which owns the window's GL context
+// the simulation fills the back frame and publishes it at the end of a tick
+// frames are triple buffered: back (simulation), ready (latest published)
+// and front (being drawn), so neither side ever waits for the other
+class RenderThread
+{
+    sf::RenderWindow& m_window;
+    FrameDrawFunc m_drawFunc;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    RenderFrame m_frames[3];
+    size_t m_back = 0;
+    size_t m_ready = 1;
+    size_t m_front = 2;
+    bool m_hasNewFrame = false;
+    bool m_drawing = false;
+    bool m_running = false;
+
+    void run();
+
+    public:
+
+    RenderThread(sf::RenderWindow& window, FrameDrawFunc drawFunc);
+    ~RenderThread();
+
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    // the frame the simulation thread is allowed to write to
+    RenderFrame& backFrame();
+
+    // hand the back frame to the render thread, replacing any frame
+    // that was published but not drawn yet
+    void publish();
+
+    // block until every published frame has been drawn
+    void sync();
+};
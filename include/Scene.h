@@ -8,6 +8,7 @@
 #include <map>
 
 class GameEngine;
+class InputScript;
 
 typedef std::map<int, std::string> ActionMap;
 
@@ -23,6 +24,9 @@ class Scene
     size_t m_currentFrame = 0;
 
     virtual void onEnd() = 0;
+    // one tick of the simulation without drawing anything, scenes that
+    // only show something (menus, loading) have nothing to step
+    virtual void step();
     void setPaused(bool paused);
 
     public:
@@ -36,7 +40,17 @@ class Scene
     virtual void sRender() = 0;
 
     virtual void doAction(const Action& action);
-    void simulate(const size_t frames);
+
+    // a watched file was written and the engine already reloaded any
+    // assets it holds
+    virtual void onFileChanged(const std::string& path);
+    // a worker thread is still building the next scene, so assets and
+    // watched files must be left alone
+    virtual bool isLoading() const;
+    // advance the scene as fast as possible, no input polling, rendering
+    // or frame pacing; scripted actions are sent before their tick
+    // returns the ticks run, fewer than asked if the scene ended
+    size_t simulate(const size_t frames, InputScript* inputs = nullptr);
     void registerAction(int inputKey, const std::string& actionName);
 
     size_t width() const;
@@ -45,5 +59,6 @@ class Scene
 
     bool hasEnded() const;
     ActionMap& getActionMap();
+    EntityManager& getEntityManager();
     void drawLine(const Vec2& p1, const Vec2& p2);
 };
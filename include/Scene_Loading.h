@@ -0,0 +1,41 @@
+#pragma once
+
+#include "GameEngine.h"
+#include "Scene.h"
+#include "Scene_Play.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+// builds a Scene_Play on a worker thread while the main thread keeps
+// pumping events and drawing a progress bar, then hands the finished
+// scene to the engine
+// the worker only reads the level and builds its entities; textures are
+// required and decorations baked on the main thread at the hand over,
+// which is the thread that owns the GL context
+class Scene_Loading : public Scene
+{
+    protected:
+
+    std::string m_levelPath;
+    sf::Text m_titleText;
+    std::atomic<float> m_progress = 0;
+    std::atomic<bool> m_done = false;
+    std::shared_ptr<Scene_Play> m_scene; // set by the worker before m_done
+    std::thread m_worker;
+
+    void init();
+    void load();
+    void update();
+    void onEnd();
+    void sDoAction(const Action& action);
+
+    public:
+
+    Scene_Loading(GameEngine* gameEngine, const std::string& levelPath);
+    ~Scene_Loading();
+    void sRender();
+    bool isLoading() const;
+};
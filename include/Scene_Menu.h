@@ -14,6 +14,7 @@ class Scene_Menu : public Scene
     std::vector<std::string> m_levelPaths;
     std::vector<sf::Text> m_menuItems;
     size_t m_selectedMenuIndex = 0;
+    float m_menuTop = 0;
 
     void init();
     void update();
@@ -1,9 +1,16 @@
 #pragma once
 
+#include "BackgroundLayer.h"
 #include "Components.h"
+#include "LevelStreamer.h"
 #include "Physics.h"
+#include "RenderQueue.h"
 #include "Scene.h"
+#include <array>
+#include <atomic>
+#include <map>
 #include <memory>
+#include <vector>
 
 class Scene_Play : public Scene
 {
@@ -13,29 +20,95 @@ class Scene_Play : public Scene
         std::string WEAPON; 
     };
 
+    // ids of every animation the game logic switches to, resolved
+    // once so the systems never look an animation up by name
+    struct AnimationIds
+    {
+        AssetId stand, air, run, standShoot, airShoot, runShoot, weapon;
+        AssetId brick, brickDebris, question, questionHit, coinSpin;
+    };
+
     protected:
 
     std::shared_ptr<Entity> m_player;
     std::string m_levelPath;
     PlayerConfig m_playerConfig;
+    AnimationIds m_anim;
     bool m_drawTextures = true;
     bool m_drawCollision = false;
     bool m_drawDrawGrid = false;
+    bool m_drawProfiler = false;
     const Vec2 m_gridSize = { 64, 64 };
-    sf::Text m_gridText, m_scoreText;
+    sf::Text m_gridText, m_scoreText, m_profilerText;
     Physics m_worldPhysics;
+    std::vector<std::shared_ptr<BackgroundLayer>> m_backgroundLayers;
+
+    // tiles are streamed in by chunk, the ones around the camera have
+    // entities and a few more ahead of the player are kept loaded
+    LevelStreamer m_streamer;
+    std::vector<AssetId> m_typeAnimations; // per tile type of the level
+    std::map<size_t, EntityVec> m_activeChunks;
+    const size_t m_activeMargin = 1; // chunks beyond the screen with entities
+    const size_t m_prefetchAhead = 2; // chunks loaded beyond those
+    // chunks last passed to the streamer, first > last before the first tick
+    size_t m_prefetchFirst = 1;
+    size_t m_prefetchLast = 0;
+
+    // solid tiles that cannot break collide through merged rectangles
+    // instead of a box each; a collider exists while any chunk it
+    // overlaps is active
+    std::vector<bool> m_typeMerged; // per tile type
+    std::vector<GridRect> m_colliders;
+    std::vector<std::vector<size_t>> m_chunkColliders;
+    std::map<size_t, std::pair<size_t, std::shared_ptr<Entity>>> m_activeColliders;
     int m_score = 0;
 
+    // the world as it was right after loading, restarting puts it back
+    // without reading or parsing the level again
+    struct Snapshot
+    {
+        EntitySnapshot entities;
+        size_t player = 0; // index into entities
+        std::vector<std::pair<size_t, std::vector<size_t>>> chunks;
+        // collider index, active chunks overlapping it, entity index
+        std::vector<std::array<size_t, 3>> colliders;
+        size_t frame = 0;
+        int score = 0;
+    };
+    Snapshot m_snapshot;
+    size_t m_restarts = 0;
+
+    // fraction of the level built so far, only set while the constructor
+    // runs on a loading scene's worker thread
+    std::atomic<float>* m_loadProgress = nullptr;
+    bool m_loaded = false;
+    std::vector<AssetId> m_requiredAssets; // every animation the level can show
+
     void init(const std::string&);
+    void resolveAnimationIds();
     Vec2 gridToMidPixel(float, float, std::shared_ptr<Entity>);
-    void loadLevel(const std::string&);
+    Vec2 gridToMidPixel(float, float, const Vec2&);
+    bool loadLevel(const std::string&);
+    void reloadLevel();
+    void captureSnapshot();
+    void setLoadProgress(float progress);
+    void addTile(const ChunkTile& tile, size_t chunk);
+    void buildColliders();
+    std::shared_ptr<Entity> addCollider(const GridRect& rect);
+    void addDecoration(BackgroundLayer& layer, AssetId animation, float gridX, float gridY);
     void spawnPlayer();
+    float cameraX() const;
+    void activateChunk(size_t chunk);
+    void deactivateChunk(size_t chunk);
     void spawnBullet(std::shared_ptr<Entity>);
+    void step();
+    void sStreaming();
     void sMovement();
     void sLifespan();
     void sCollision();
     void sAnimation();
     void sRender();
+    std::string profilerReport() const;
     void sDoAction(const Action&);
     void onEnd();
     void setPaused(bool);
@@ -46,6 +119,24 @@ class Scene_Play : public Scene
     void addScore(int x);
 
     public:
-    Scene_Play(GameEngine*, std::string&);
+    Scene_Play(GameEngine*, const std::string&, std::atomic<float>* progress = nullptr);
+    // false if the level file could not be read, the scene is then empty
+    // and must not be run
+    bool isLoaded() const;
+    // requires the level's textures and bakes its decorations, on the
+    // thread that owns the GL context; constructing with a progress
+    // counter leaves this to the caller
+    void finishLoading();
     void update();
+    // back to the start of the level, in memory
+    void restart();
+    size_t restartCount() const; // falling into a hole restarts too
+    int score() const;
+
+    // writes what an agent sees into out without allocating: player
+    // values, tile occupancy of a gridWidth x gridHeight window around
+    // the player, then up to maxEntities bullets and coins
+    // the exact layout is documented with the C interface in EnvApi.h
+    void observe(float* out, int gridWidth, int gridHeight, size_t maxEntities);
+    void onFileChanged(const std::string& path);
 };
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a fixed set of workers, each with its own task deque
+// tasks are handed out round robin; a worker runs its newest task first
+// and, once its deque is empty, steals the oldest task of another one,
+// so tasks of very different length still keep every worker busy
+class ThreadPool
+{
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> m_queues; // one per worker
+    std::vector<std::thread> m_threads;
+    std::atomic<size_t> m_queued = 0; // tasks waiting in any deque
+    size_t m_unfinished = 0; // submitted and not yet done
+    size_t m_nextQueue = 0;
+    bool m_running = true;
+    std::mutex m_mutex; // guards the counters above, for sleeping and wait()
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_allDone;
+
+    bool take(size_t worker, std::function<void()>& task);
+    void run(size_t worker);
+
+    public:
+
+    // 0 threads uses one per hardware thread
+    ThreadPool(size_t threadCount = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+    // blocks until every task submitted so far has finished
+    void wait();
+    size_t size() const;
+};
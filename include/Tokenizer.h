@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// splits text into whitespace separated tokens without copying them
+// tokens are views into the buffer, numbers are converted with
+// std::from_chars, so nothing is allocated and no locale is consulted
+// errors are reported as path:line:column of the offending token
+class Tokenizer
+{
+    std::string m_path;
+    const char* m_pos;
+    const char* m_end;
+    size_t m_line = 1;
+    const char* m_lineStart;
+    size_t m_tokenLine = 1;
+    size_t m_tokenColumn = 1;
+
+    void skipWhitespace();
+
+    public:
+
+    Tokenizer(const std::string& path, const char* data, size_t size);
+
+    // false once the input is used up
+    bool next(std::string_view& token);
+
+    // the next token as a value of the line being read, false with an
+    // error naming what was expected if it is missing or malformed
+    bool read(std::string_view& value, const char* what);
+    bool read(float& value, const char* what);
+    bool read(int& value, const char* what);
+
+    // prints the message at the last token's position, always false
+    bool error(const std::string& message) const;
+};
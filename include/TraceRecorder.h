@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// records spans and counters into Chrome trace event JSON, which
+// chrome://tracing and ui.perfetto.dev open as a timeline per thread
+// every thread appends to its own chain of fixed size blocks, so
+// recording takes no lock; the file can be written at any time, events
+// still being appended just miss the cut
+class TraceRecorder
+{
+    static constexpr size_t NAME_SIZE = 48;
+    static constexpr size_t BLOCK_SIZE = 1024; // events
+
+    struct Event
+    {
+        char category[16];
+        char name[NAME_SIZE];
+        char series[24]; // counters only
+        char phase; // 'X' span, 'C' counter
+        double start; // microseconds since start()
+        double duration;
+        std::int64_t value;
+    };
+
+    struct Block
+    {
+        std::array<Event, BLOCK_SIZE> events;
+        std::atomic<size_t> count = 0; // published events
+        std::atomic<Block*> next = nullptr;
+    };
+
+    struct ThreadBuffer
+    {
+        size_t id = 0;
+        std::string name;
+        std::unique_ptr<Block> first;
+        Block* last = nullptr; // only touched by the owning thread
+    };
+
+    std::vector<std::unique_ptr<ThreadBuffer>> m_threads;
+    std::mutex m_mutex; // guards m_threads and thread names, never taken per event
+    std::atomic<bool> m_recording = false;
+    std::chrono::steady_clock::time_point m_start;
+
+    ThreadBuffer& buffer();
+    Event& append(char phase, const char* category, const char* name);
+    double microseconds(std::chrono::steady_clock::time_point time) const;
+
+    public:
+
+    ~TraceRecorder();
+
+    static TraceRecorder& instance();
+
+    void start();
+    bool isRecording() const;
+
+    // shown as the timeline row of the calling thread, only while recording
+    void setThreadName(const std::string& name);
+
+    void span(
+        const char* category,
+        const char* name,
+        std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end
+    );
+    // one counter track per name, with a line per series
+    void counter(const char* name, const std::string& series, std::int64_t value);
+
+    bool write(const std::string& path);
+};
@@ -0,0 +1,210 @@
+#include "AssetPack.h"
+#include "FixedName.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+bool copyPackName(char (&dest)[PACK_NAME_SIZE], const std::string& name) {
+    if (!copyName(dest, name)) {
+        std::cerr << "Asset name " << name << " is too long for a pack!\n";
+        return false;
+    }
+    return true;
+}
+
+std::uint64_t align16(std::uint64_t offset) {
+    return (offset + 15) & ~(std::uint64_t)15;
+}
+
+// checked without computing offset + length, which a corrupt pack can
+// make wrap around
+bool inFile(std::uint64_t offset, std::uint64_t length, std::uint64_t fileSize) {
+    return offset <= fileSize && length <= fileSize - offset;
+}
+
+// names are read as C strings, a missing terminator would run past them
+bool isTerminated(const char (&name)[PACK_NAME_SIZE]) {
+    return std::memchr(name, '\0', PACK_NAME_SIZE) != nullptr;
+}
+
+}
+
+bool AssetPack::write(
+    const std::string& path,
+    const std::vector<TextureSource>& textures,
+    const std::vector<AnimationSource>& animations,
+    const std::vector<FontSource>& fonts
+) {
+    PackHeader header;
+    std::memcpy(header.magic, "KMPK", 4);
+    header.version = PACK_VERSION;
+    header.textureCount = (std::uint32_t)textures.size();
+    header.animationCount = (std::uint32_t)animations.size();
+    header.fontCount = (std::uint32_t)fonts.size();
+    header.reserved = 0;
+
+    // lay out the data blobs behind the index
+    std::uint64_t offset = sizeof(PackHeader)
+        + textures.size() * sizeof(PackTexture)
+        + animations.size() * sizeof(PackAnimation)
+        + fonts.size() * sizeof(PackFont);
+
+    std::vector<PackTexture> textureTable(textures.size());
+    for (size_t i = 0; i < textures.size(); i++) {
+        if (!copyPackName(textureTable[i].name, textures[i].name)) {
+            return false;
+        }
+        textureTable[i].width = textures[i].width;
+        textureTable[i].height = textures[i].height;
+        offset = align16(offset);
+        textureTable[i].offset = offset;
+        offset += (std::uint64_t)textures[i].width * textures[i].height * 4;
+    }
+
+    std::vector<PackAnimation> animationTable(animations.size());
+    for (size_t i = 0; i < animations.size(); i++) {
+        if (!copyPackName(animationTable[i].name, animations[i].name)) {
+            return false;
+        }
+        animationTable[i].texture = animations[i].texture;
+        animationTable[i].frames = animations[i].frames;
+        animationTable[i].speed = animations[i].speed;
+        animationTable[i].reserved = 0;
+    }
+
+    std::vector<PackFont> fontTable(fonts.size());
+    for (size_t i = 0; i < fonts.size(); i++) {
+        if (!copyPackName(fontTable[i].name, fonts[i].name)) {
+            return false;
+        }
+        offset = align16(offset);
+        fontTable[i].offset = offset;
+        fontTable[i].size = fonts[i].data.size();
+        offset += fonts[i].data.size();
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Could not write " << path << "!\n";
+        return false;
+    }
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)textureTable.data(), textureTable.size() * sizeof(PackTexture));
+    file.write((const char*)animationTable.data(), animationTable.size() * sizeof(PackAnimation));
+    file.write((const char*)fontTable.data(), fontTable.size() * sizeof(PackFont));
+
+    auto pad = [&file](std::uint64_t target) {
+        while ((std::uint64_t)file.tellp() < target) {
+            file.put(0);
+        }
+    };
+    for (size_t i = 0; i < textures.size(); i++) {
+        pad(textureTable[i].offset);
+        file.write(
+            (const char*)textures[i].pixels,
+            (std::streamsize)textures[i].width * textures[i].height * 4
+        );
+    }
+    for (size_t i = 0; i < fonts.size(); i++) {
+        pad(fontTable[i].offset);
+        file.write(fonts[i].data.data(), fonts[i].data.size());
+    }
+    return (bool)file;
+}
+
+bool AssetPack::open(const std::string& path) {
+    if (!m_file.open(path)) {
+        std::cerr << "Could not open asset pack " << path << "!\n";
+        return false;
+    }
+
+    const std::uint8_t* data = m_file.data();
+    size_t size = m_file.size();
+    if (size < sizeof(PackHeader)) {
+        std::cerr << path << " is not an asset pack!\n";
+        return false;
+    }
+    m_header = (const PackHeader*)data;
+    if (std::memcmp(m_header->magic, "KMPK", 4) != 0) {
+        std::cerr << path << " is not an asset pack!\n";
+        return false;
+    }
+    if (m_header->version != PACK_VERSION) {
+        std::cerr << path << " has pack version " << m_header->version
+            << ", expected " << PACK_VERSION << "!\n";
+        return false;
+    }
+
+    size_t indexSize = sizeof(PackHeader)
+        + m_header->textureCount * sizeof(PackTexture)
+        + m_header->animationCount * sizeof(PackAnimation)
+        + m_header->fontCount * sizeof(PackFont);
+    if (size < indexSize) {
+        std::cerr << path << " is truncated!\n";
+        return false;
+    }
+    m_textures = (const PackTexture*)(data + sizeof(PackHeader));
+    m_animations = (const PackAnimation*)(m_textures + m_header->textureCount);
+    m_fonts = (const PackFont*)(m_animations + m_header->animationCount);
+
+    for (size_t i = 0; i < textureCount(); i++) {
+        const PackTexture& t = m_textures[i];
+        // width * height fits in 64 bits, times 4 may not
+        std::uint64_t pixelCount = (std::uint64_t)t.width * t.height;
+        if (!isTerminated(t.name) || pixelCount > size / 4
+            || !inFile(t.offset, pixelCount * 4, size)) {
+            std::cerr << path << " has a broken texture table!\n";
+            return false;
+        }
+    }
+    for (size_t i = 0; i < fontCount(); i++) {
+        if (!isTerminated(m_fonts[i].name)
+            || !inFile(m_fonts[i].offset, m_fonts[i].size, size)) {
+            std::cerr << path << " has a broken font table!\n";
+            return false;
+        }
+    }
+    for (size_t i = 0; i < animationCount(); i++) {
+        if (!isTerminated(m_animations[i].name)
+            || m_animations[i].texture >= textureCount()) {
+            std::cerr << path << " has a broken animation table!\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t AssetPack::textureCount() const {
+    return m_header ? m_header->textureCount : 0;
+}
+
+size_t AssetPack::animationCount() const {
+    return m_header ? m_header->animationCount : 0;
+}
+
+size_t AssetPack::fontCount() const {
+    return m_header ? m_header->fontCount : 0;
+}
+
+const PackTexture& AssetPack::texture(size_t index) const {
+    return m_textures[index];
+}
+
+const PackAnimation& AssetPack::animation(size_t index) const {
+    return m_animations[index];
+}
+
+const PackFont& AssetPack::font(size_t index) const {
+    return m_fonts[index];
+}
+
+const std::uint8_t* AssetPack::pixels(const PackTexture& texture) const {
+    return m_file.data() + texture.offset;
+}
+
+const void* AssetPack::fontData(const PackFont& font) const {
+    return m_file.data() + font.offset;
+}
@@ -1,76 +1,674 @@
 #include "Assets.h"
+#include "MappedFile.h"
+#include "Tokenizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <thread>
+
+// 0 when the file is missing, only used for reporting
+static size_t fileSize(const std::string& path) {
+    std::error_code error;
+    std::uintmax_t size = std::filesystem::file_size(path, error);
+    return error ? 0 : (size_t)size;
+}
 
-void Assets::addTexture(const std::string& name, const std::string& path) {
+AssetId Assets::addTexture(const std::string& name, const std::string& path) {
     sf::Texture texture;
     if (!texture.loadFromFile(path)) {
         std::cerr << "Could not load image " << path << "!\n";
         exit(-1);
     }
-    m_textures[name] = texture;
+    AssetId id = addTexture(name, std::move(texture));
+    m_textures[id].path = path;
+    return id;
+}
+
+AssetId Assets::addTexture(const std::string& name, sf::Texture&& texture) {
+    AssetId id = declareTexture(name);
+    makeResident(id, texture);
+    return id;
+}
+
+AssetId Assets::declareTexture(const std::string& name) {
+    auto it = m_textureIds.find(name);
+    if (it != m_textureIds.end()) {
+        return it->second;
+    }
+    AssetId id = m_textures.size();
+    m_textures.push_back(TextureEntry());
+    m_textures.back().name = name;
+    m_textureIds[name] = id;
+    return id;
+}
+
+void Assets::setTextureSize(AssetId id, const sf::Vector2u& size) {
+    if (m_textures[id].size == size) {
+        return;
+    }
+    m_textures[id].size = size;
+    // frame sizes of animations using this texture depend on it
+    for (auto& def : m_animations) {
+        if (def.texture == id) {
+            def.size = Vec2((float)size.x / def.frameCount, (float)size.y);
+        }
+    }
+}
+
+void Assets::makeResident(AssetId id, sf::Texture& texture) {
+    TextureEntry& entry = m_textures[id];
+    if (entry.texture) {
+        // swap into the existing texture, anything pointing at it stays valid
+        m_residentBytes -= (size_t)entry.size.x * entry.size.y * 4;
+        entry.texture->swap(texture);
+    }
+    else {
+        // sf::Texture has no move constructor, swapping avoids a GPU copy
+        entry.texture = std::make_unique<sf::Texture>();
+        entry.texture->swap(texture);
+    }
+    setTextureSize(id, entry.texture->getSize());
+    m_residentBytes += (size_t)entry.size.x * entry.size.y * 4;
+}
+
+void Assets::evict(AssetId id) {
+    TextureEntry& entry = m_textures[id];
+    if (!entry.texture) {
+        return;
+    }
+    entry.texture.reset();
+    m_residentBytes -= (size_t)entry.size.x * entry.size.y * 4;
+}
+
+void Assets::loadTextures(const std::vector<AssetId>& ids) {
+    if (m_metadataOnly) {
+        return;
+    }
+    // pack textures are uploaded straight from the mapping, png textures
+    // are decoded in parallel first and then uploaded on this thread
+    std::vector<ImageRequest> images;
+    std::vector<AssetId> imageIds;
+    for (AssetId id : ids) {
+        TextureEntry& entry = m_textures[id];
+        if (entry.texture) {
+            continue;
+        }
+        if (entry.packIndex != NO_ASSET) {
+            LoadTimer timer;
+            const PackTexture& packed = m_pack->texture(entry.packIndex);
+            sf::Texture texture;
+            if (!texture.create(packed.width, packed.height)) {
+                std::cerr << "Could not create texture " << entry.name << "!\n";
+                exit(-1);
+            }
+            texture.update(m_pack->pixels(packed));
+            makeResident(id, texture);
+            profile(
+                LoadPhase::UPLOAD, entry.name, timer.seconds(),
+                (size_t)packed.width * packed.height * 4
+            );
+        }
+        else if (!entry.path.empty()) {
+            ImageRequest request;
+            request.name = entry.name;
+            request.path = entry.path;
+            images.push_back(request);
+            imageIds.push_back(id);
+        }
+    }
+
+    size_t decodeThreads = decodeImages(images);
+    if (m_profiler) {
+        m_profiler->noteDecodeThreads(decodeThreads);
+    }
+    for (size_t i = 0; i < images.size(); i++) {
+        if (!images[i].loaded) {
+            std::cerr << "Could not load image " << images[i].path << "!\n";
+            exit(-1);
+        }
+        profile(LoadPhase::DECODE, images[i].name, images[i].seconds, images[i].fileBytes);
+
+        LoadTimer timer;
+        sf::Texture texture;
+        if (!texture.loadFromImage(images[i].image)) {
+            std::cerr << "Could not create texture " << images[i].name << "!\n";
+            exit(-1);
+        }
+        makeResident(imageIds[i], texture);
+        sf::Vector2u size = images[i].image.getSize();
+        profile(
+            LoadPhase::UPLOAD, images[i].name, timer.seconds(),
+            (size_t)size.x * size.y * 4
+        );
+    }
+}
+
+void Assets::trim() {
+    if (m_textureBudget == 0 || m_residentBytes <= m_textureBudget) {
+        return;
+    }
+    // textures needed by the latest require() are never evicted
+    std::vector<AssetId> candidates;
+    for (AssetId id = 0; id < m_textures.size(); id++) {
+        if (m_textures[id].texture && m_textures[id].lastUsed < m_useClock) {
+            candidates.push_back(id);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](AssetId a, AssetId b) {
+        return m_textures[a].lastUsed < m_textures[b].lastUsed;
+    });
+    for (AssetId id : candidates) {
+        if (m_residentBytes <= m_textureBudget) {
+            break;
+        }
+        evict(id);
+    }
+}
+
+static bool samePath(const std::string& a, const std::string& b) {
+    std::error_code error;
+    return std::filesystem::equivalent(a, b, error);
+}
+
+bool Assets::reloadTexture(AssetId id) {
+    TextureEntry& entry = m_textures[id];
+    if (!entry.texture) {
+        // the new file is picked up whenever it is next required
+        return true;
+    }
+    // a failed reload keeps the old texture, the file may still be
+    // in the middle of being saved
+    sf::Texture texture;
+    if (!texture.loadFromFile(entry.path)) {
+        std::cerr << "Could not reload image " << entry.path << "!\n";
+        return false;
+    }
+    makeResident(id, texture);
+    return true;
+}
+
+void Assets::reloadManifest() {
+    // a config that does not parse, e.g. while it is being edited,
+    // leaves everything as it was
+    AssetManifest manifest;
+    if (!readManifest(m_manifestPath, manifest)) {
+        return;
+    }
+
+    for (auto& entry : manifest.fonts) {
+        auto it = m_fontPaths.find(entry.name);
+        if (it == m_fontPaths.end() || it->second != entry.path) {
+            addFont(entry.name, entry.path);
+        }
+    }
+
+    for (auto& entry : manifest.textures) {
+        auto it = m_textureIds.find(entry.name);
+        if (it != m_textureIds.end() && m_textures[it->second].path == entry.path) {
+            continue;
+        }
+        AssetId id = declareTexture(entry.name);
+        m_textures[id].path = entry.path;
+        reloadTexture(id);
+    }
+
+    // animations are replaced in place, so entities playing them pick up
+    // the change; one moved to another texture keeps being drawable
+    std::vector<AssetId> textures;
+    for (auto& entry : manifest.animations) {
+        auto it = m_animationIds.find(entry.name);
+        bool wasResident = it != m_animationIds.end()
+            && isResident(m_animations[it->second].texture);
+        AssetId id = addAnimation(entry.name, entry.texture, entry.frames, entry.speed);
+        if (wasResident) {
+            textures.push_back(m_animations[id].texture);
+        }
+    }
+    loadTextures(textures);
+}
+
+std::vector<std::string> Assets::sourceFiles() const {
+    std::vector<std::string> files;
+    if (!m_manifestPath.empty()) {
+        files.push_back(m_manifestPath);
+    }
+    for (auto& entry : m_textures) {
+        if (!entry.path.empty()) {
+            files.push_back(entry.path);
+        }
+    }
+    for (auto& [name, path] : m_fontPaths) {
+        files.push_back(path);
+    }
+    return files;
+}
+
+bool Assets::isManifest(const std::string& path) const {
+    return !m_manifestPath.empty() && samePath(path, m_manifestPath);
+}
+
+bool Assets::reload(const std::string& path) {
+    if (isManifest(path)) {
+        reloadManifest();
+        return true;
+    }
+
+    bool used = false;
+    for (AssetId id = 0; id < m_textures.size(); id++) {
+        if (!m_textures[id].path.empty() && samePath(path, m_textures[id].path)) {
+            reloadTexture(id);
+            used = true;
+        }
+    }
+    for (auto& [name, fontPath] : m_fontPaths) {
+        if (samePath(path, fontPath)) {
+            sf::Font font;
+            if (font.loadFromFile(fontPath)) {
+                m_fonts[name] = font;
+            }
+            else {
+                std::cerr << "Could not reload font " << fontPath << "!\n";
+            }
+            used = true;
+        }
+    }
+    return used;
+}
+
+void Assets::profile(
+    LoadPhase phase,
+    const std::string& name,
+    double seconds,
+    size_t bytes
+) {
+    if (m_profiler) {
+        m_profiler->add(phase, name, seconds, bytes);
+    }
+}
+
+void Assets::setProfiler(LoadProfiler* profiler) {
+    m_profiler = profiler;
+}
+
+void Assets::setLazyLoading(bool lazy) {
+    m_lazy = lazy;
+}
+
+void Assets::setTextureBudget(size_t bytes) {
+    m_textureBudget = bytes;
+}
+
+void Assets::setMetadataOnly(bool metadataOnly) {
+    m_metadataOnly = metadataOnly;
 }
 
-void Assets::addAnimation(const std::string& name, Animation animation) {
-    m_animations[name] = animation;
+bool Assets::isMetadataOnly() const {
+    return m_metadataOnly;
+}
+
+void Assets::require(const std::vector<AssetId>& animations) {
+    // nothing becomes resident, and the assets stay read-only for
+    // levels loaded from several threads at once
+    if (m_metadataOnly) {
+        return;
+    }
+    m_useClock++;
+    std::vector<AssetId> textures;
+    for (AssetId animation : animations) {
+        AssetId texture = m_animations[animation].texture;
+        if (m_textures[texture].lastUsed != m_useClock) {
+            m_textures[texture].lastUsed = m_useClock;
+            textures.push_back(texture);
+        }
+    }
+    loadTextures(textures);
+    trim();
+}
+
+bool Assets::isResident(AssetId texture) const {
+    return m_textures[texture].texture != nullptr;
+}
+
+size_t Assets::residentBytes() const {
+    return m_residentBytes;
+}
+
+AssetId Assets::addAnimation(
+    const std::string& name,
+    const std::string& texture,
+    size_t frameCount,
+    size_t speed
+) {
+    AssetId textureId = getTextureId(texture);
+    const sf::Vector2u& textureSize = m_textures[textureId].size;
+
+    // the frame size is filled in by setTextureSize if the texture
+    // is not loaded yet
+    AnimationDef def;
+    def.name = name;
+    def.texture = textureId;
+    def.frameCount = frameCount <= 0 ? 1 : frameCount;
+    def.speed = speed <= 0 ? 1 : speed;
+    if (textureSize.x > 0) {
+        def.size = Vec2((float)textureSize.x / def.frameCount, (float)textureSize.y);
+    }
+
+    auto it = m_animationIds.find(name);
+    if (it != m_animationIds.end()) {
+        def.id = it->second;
+        m_animations[def.id] = def;
+        return def.id;
+    }
+    def.id = m_animations.size();
+    m_animations.push_back(def);
+    m_animationIds[name] = def.id;
+    return def.id;
 }
 
 void Assets::addFont(const std::string& name, const std::string& path) {
+    LoadTimer timer;
     sf::Font font;
     if (!font.loadFromFile(path)) {
         std::cerr << "Could not load font!\n";
         exit(-1);
     }
     m_fonts[name] = font;
+    m_fontPaths[name] = path;
+    profile(LoadPhase::FONT, name, timer.seconds(), fileSize(path));
+}
+
+AssetId Assets::getTextureId(const std::string& name) const {
+    return m_textureIds.at(name);
+}
+
+AssetId Assets::getAnimationId(const std::string& name) const {
+    return m_animationIds.at(name);
+}
+
+const sf::Texture& Assets::getTexture(AssetId id) const {
+    if (!m_textures[id].texture) {
+        std::cerr << "Texture " << m_textures[id].name << " was used without being required!\n";
+        exit(-1);
+    }
+    return *m_textures[id].texture;
 }
 
 const sf::Texture& Assets::getTexture(const std::string& name) const {
-    return m_textures.at(name);
+    return getTexture(getTextureId(name));
+}
+
+const AnimationDef& Assets::getAnimationDef(AssetId id) const {
+    return m_animations[id];
 }
 
-const Animation& Assets::getAnimation(const std::string& name) const {
-    return m_animations.at(name);
+Animation Assets::getAnimation(AssetId id) const {
+    return Animation(m_animations[id]);
+}
+
+Animation Assets::getAnimation(const std::string& name) const {
+    return getAnimation(getAnimationId(name));
 }
 
 const sf::Font& Assets::getFont(const std::string& name) const {
     return m_fonts.at(name);
 }
 
-void Assets::loadFromFile(const std::string& path) {
-    std::ifstream file(path);
-    if (!file) {
-        std::cerr << "Could not load config.txt file!\n";
-        exit(-1);
+bool Assets::readImageSize(const std::string& path, sf::Vector2u& size) {
+    // a png starts with its signature and then the IHDR chunk, which
+    // holds the size as big endian 32 bit integers
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    unsigned char header[24];
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read((char*)header, sizeof(header))) {
+        return false;
+    }
+    if (std::memcmp(header, signature, 8) == 0 && std::memcmp(header + 12, "IHDR", 4) == 0) {
+        auto read32 = [&header](int offset) {
+            return (unsigned int)header[offset] << 24 | (unsigned int)header[offset + 1] << 16
+                | (unsigned int)header[offset + 2] << 8 | (unsigned int)header[offset + 3];
+        };
+        size = sf::Vector2u(read32(16), read32(20));
+        return true;
+    }
+
+    // any other format is decoded once, still without a GL context
+    file.close();
+    sf::Image image;
+    if (!image.loadFromFile(path)) {
+        return false;
+    }
+    size = image.getSize();
+    return true;
+}
+
+size_t Assets::decodeImages(std::vector<ImageRequest>& requests) {
+    // decoding pngs needs no GL context, so it is spread over worker
+    // threads which pull the next request from a shared counter
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> busyThreads = 0;
+    auto worker = [&]() {
+        size_t i = next++;
+        if (i < requests.size()) {
+            busyThreads++;
+        }
+        for (; i < requests.size(); i = next++) {
+            LoadTimer timer;
+            requests[i].loaded = requests[i].image.loadFromFile(requests[i].path);
+            requests[i].seconds = timer.seconds();
+            requests[i].fileBytes = fileSize(requests[i].path);
+        }
+    };
+
+    size_t threadCount = std::min<size_t>(
+        std::max(1u, std::thread::hardware_concurrency()),
+        requests.size()
+    );
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
     }
-    std::string head;
-    while (file >> head) {
-        if (head == "Font") {
-            std::string font_name;
-            std::string font_path;
-            file >> font_name >> font_path;
-            addFont(font_name, font_path);
+    return busyThreads;
+}
+
+std::vector<Assets::ImageRequest> Assets::decodeManifestImages(
+    const AssetManifest& manifest
+) {
+    std::vector<ImageRequest> images(manifest.textures.size());
+    for (size_t i = 0; i < images.size(); i++) {
+        images[i].name = manifest.textures[i].name;
+        images[i].path = manifest.textures[i].path;
+    }
+    decodeImages(images);
+    for (auto& request : images) {
+        if (!request.loaded) {
+            std::cerr << "Could not load image " << request.path << "!\n";
+            exit(-1);
         }
-        else if (head == "Texture") {
-            std::string name;
-            std::string path;
-            file >> name >> path;
-            addTexture(name, path);
+    }
+    return images;
+}
+
+bool Assets::readManifest(const std::string& path, AssetManifest& manifest) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Could not load assets config " << path << "!\n";
+        return false;
+    }
+    Tokenizer tokens(path, (const char*)file.data(), file.size());
+
+    manifest = AssetManifest();
+    std::string_view head;
+    while (tokens.next(head)) {
+        if (head == "Font" || head == "Texture") {
+            std::string_view name, filePath;
+            if (!tokens.read(name, "a name") || !tokens.read(filePath, "a file path")) {
+                return false;
+            }
+            AssetManifest::Entry entry;
+            entry.name = name;
+            entry.path = filePath;
+            (head == "Font" ? manifest.fonts : manifest.textures).push_back(entry);
         }
         else if (head == "Animation") {
-            std::string aniName;
-            std::string texName;
-            int frames, speed;
-            file >> aniName >> texName >> frames >> speed;
-            const sf::Texture& tex = getTexture(texName);
-            addAnimation(
-                aniName, 
-                Animation(aniName, tex, frames, speed)
-            );
+            std::string_view name, texture;
+            AssetManifest::AnimationEntry entry;
+            if (!tokens.read(name, "a name")
+                || !tokens.read(texture, "a texture name")
+                || !tokens.read(entry.frames, "a frame count")
+                || !tokens.read(entry.speed, "a speed")) {
+                return false;
+            }
+            entry.name = name;
+            entry.texture = texture;
+            manifest.animations.push_back(entry);
         }
         else {
-            std::cerr << "head to " << head << "\n";
-            std::cerr << "The config file format is incorrect!\n";
+            return tokens.error(
+                "unknown entry '" + std::string(head) + "', expected Font, Texture or Animation"
+            );
+        }
+    }
+    return true;
+}
+
+void Assets::loadFromFile(const std::string& path) {
+    m_manifestPath = path;
+    LoadTimer timer;
+    AssetManifest manifest;
+    if (!readManifest(path, manifest)) {
+        exit(-1);
+    }
+    profile(LoadPhase::CONFIG, path, timer.seconds(), fileSize(path));
+
+    for (auto& font : manifest.fonts) {
+        addFont(font.name, font.path);
+    }
+
+    std::vector<AssetId> textures;
+    for (auto& entry : manifest.textures) {
+        AssetId id = declareTexture(entry.name);
+        m_textures[id].path = entry.path;
+        textures.push_back(id);
+        if (m_metadataOnly) {
+            LoadTimer sizeTimer;
+            sf::Vector2u size;
+            if (!readImageSize(entry.path, size)) {
+                std::cerr << "Could not load image " << entry.path << "!\n";
+                exit(-1);
+            }
+            setTextureSize(id, size);
+            profile(LoadPhase::METADATA, entry.name, sizeTimer.seconds(), 0);
+        }
+    }
+    for (auto& entry : manifest.animations) {
+        addAnimation(entry.name, entry.texture, entry.frames, entry.speed);
+    }
+
+    if (!m_lazy) {
+        loadTextures(textures);
+    }
+}
+
+void Assets::loadFromPack(const std::string& path) {
+    LoadTimer timer;
+    m_pack = std::make_shared<AssetPack>();
+    if (!m_pack->open(path)) {
+        exit(-1);
+    }
+    profile(LoadPhase::CONFIG, path, timer.seconds(), fileSize(path));
+
+    std::vector<AssetId> textures;
+    for (size_t i = 0; i < m_pack->textureCount(); i++) {
+        const PackTexture& entry = m_pack->texture(i);
+        AssetId id = declareTexture(entry.name);
+        m_textures[id].packIndex = i;
+        setTextureSize(id, sf::Vector2u(entry.width, entry.height));
+        textures.push_back(id);
+    }
+
+    for (size_t i = 0; i < m_pack->animationCount(); i++) {
+        const PackAnimation& entry = m_pack->animation(i);
+        addAnimation(
+            entry.name,
+            m_pack->texture(entry.texture).name,
+            entry.frames,
+            entry.speed
+        );
+    }
+
+    for (size_t i = 0; i < m_pack->fontCount(); i++) {
+        LoadTimer timer;
+        const PackFont& entry = m_pack->font(i);
+        if (!m_fonts[entry.name].loadFromMemory(m_pack->fontData(entry), entry.size)) {
+            std::cerr << "Could not load font!\n";
             exit(-1);
         }
+        profile(LoadPhase::FONT, entry.name, timer.seconds(), entry.size);
+    }
+
+    if (!m_lazy) {
+        loadTextures(textures);
+    }
+}
+
+bool Assets::bakePack(const std::string& configPath, const std::string& packPath) {
+    AssetManifest manifest;
+    if (!readManifest(configPath, manifest)) {
+        return false;
+    }
+    std::vector<ImageRequest> images = decodeManifestImages(manifest);
+
+    std::vector<AssetPack::TextureSource> textures;
+    std::map<std::string, std::uint32_t> textureIndex;
+    for (auto& request : images) {
+        AssetPack::TextureSource source;
+        source.name = request.name;
+        source.width = request.image.getSize().x;
+        source.height = request.image.getSize().y;
+        source.pixels = request.image.getPixelsPtr();
+        textureIndex[request.name] = (std::uint32_t)textures.size();
+        textures.push_back(source);
+    }
+
+    std::vector<AssetPack::AnimationSource> animations;
+    for (auto& entry : manifest.animations) {
+        if (textureIndex.find(entry.texture) == textureIndex.end()) {
+            std::cerr << "Animation " << entry.name << " uses unknown texture "
+                << entry.texture << "!\n";
+            return false;
+        }
+        AssetPack::AnimationSource source;
+        source.name = entry.name;
+        source.texture = textureIndex[entry.texture];
+        source.frames = entry.frames;
+        source.speed = entry.speed;
+        animations.push_back(source);
     }
+
+    std::vector<AssetPack::FontSource> fonts;
+    for (auto& entry : manifest.fonts) {
+        std::ifstream file(entry.path, std::ios::binary);
+        if (!file) {
+            std::cerr << "Could not load font " << entry.path << "!\n";
+            return false;
+        }
+        AssetPack::FontSource source;
+        source.name = entry.name;
+        source.data.assign(
+            std::istreambuf_iterator<char>(file),
+            std::istreambuf_iterator<char>()
+        );
+        fonts.push_back(source);
+    }
+
+    return AssetPack::write(packPath, textures, animations, fonts);
 }
@@ -0,0 +1,62 @@
+#include "BackgroundLayer.h"
+#include "RenderQueue.h"
+
+BackgroundLayer::BackgroundLayer(const std::string& name, float parallax)
+    : m_name(name)
+    , m_parallax(parallax) {}
+
+void BackgroundLayer::add(
+    const sf::Texture* texture,
+    const sf::IntRect& rect,
+    const Vec2& pos,
+    const Vec2& scale
+) {
+    Mesh* mesh = nullptr;
+    for (auto& m : m_meshes) {
+        if (m.texture == texture) {
+            mesh = &m;
+            break;
+        }
+    }
+    if (!mesh) {
+        m_meshes.push_back(Mesh());
+        mesh = &m_meshes.back();
+        mesh->texture = texture;
+    }
+
+    float transform[6];
+    RenderQueue::makeTransform(transform, rect, pos, scale, 0);
+    RenderQueue::appendQuad(mesh->vertices, rect, transform);
+    m_quadCount++;
+}
+
+sf::Vector2f BackgroundLayer::offset(float cameraX) const {
+    // a layer with parallax 0.5 covers half the distance the camera does,
+    // so it is pushed along by the other half
+    return sf::Vector2f(cameraX * (1.0f - m_parallax), 0);
+}
+
+void BackgroundLayer::draw(sf::RenderTarget& target, const sf::Vector2f& offset) const {
+    sf::RenderStates states;
+    states.transform.translate(offset);
+    for (auto& mesh : m_meshes) {
+        states.texture = mesh.texture;
+        target.draw(mesh.vertices.data(), mesh.vertices.size(), sf::Triangles, states);
+    }
+}
+
+const std::string& BackgroundLayer::name() const {
+    return m_name;
+}
+
+float BackgroundLayer::parallax() const {
+    return m_parallax;
+}
+
+size_t BackgroundLayer::meshCount() const {
+    return m_meshes.size();
+}
+
+size_t BackgroundLayer::quadCount() const {
+    return m_quadCount;
+}
@@ -12,7 +12,8 @@ Entity::Entity(const size_t i, const std::string& t)
         CBoundingBox(),
         CAnimation(),
         CGravity(),
-        CState()
+        CState(),
+        CChunk()
     );
 }
 
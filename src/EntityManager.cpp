@@ -1,11 +1,14 @@
 #include "EntityManager.h"
 #include "Entity.h"
+#include "FrameProfiler.h"
 #include <memory>
 #include <vector>
 
 EntityManager::EntityManager() {}
 
 void EntityManager::update() {
+    PROFILE_SCOPE(ENTITY_UPDATE);
+
     // add entities from m_entitiesToAdd the proper location(s) 
     //   - add them to the vector of all entities
     //   - add them to the vector inside the map, with the tag as a k
@@ -43,6 +46,43 @@ std::shared_ptr<Entity> EntityManager::addEntity(const std::string& tag) {
     return entity;
 }
 
+void EntityManager::reserve(size_t count) {
+    m_entitiesToAdd.reserve(m_entitiesToAdd.size() + count);
+    m_entities.reserve(m_entities.size() + m_entitiesToAdd.size() + count);
+}
+
+EntitySnapshot EntityManager::snapshot() const {
+    EntitySnapshot snapshot;
+    snapshot.totalEntities = m_totalEntities;
+    snapshot.entities.reserve(m_entities.size() + m_entitiesToAdd.size());
+    for (const EntityVec* vec : { &m_entities, &m_entitiesToAdd }) {
+        for (auto& e : *vec) {
+            if (e->isActive()) {
+                snapshot.entities.push_back({ e->m_id, e->m_tag, e->m_components });
+            }
+        }
+    }
+    return snapshot;
+}
+
+void EntityManager::restore(const EntitySnapshot& snapshot) {
+    // entities held elsewhere from before the restore are left alone,
+    // they are just no longer part of the world
+    m_entities.clear();
+    m_entitiesToAdd.clear();
+    for (auto& [tag, entityVec] : m_entityMap) {
+        entityVec.clear();
+    }
+    m_entities.reserve(snapshot.entities.size());
+    for (auto& record : snapshot.entities) {
+        auto entity = std::shared_ptr<Entity>(new Entity(record.id, record.tag));
+        entity->m_components = record.components;
+        m_entities.push_back(entity);
+        m_entityMap[record.tag].push_back(entity);
+    }
+    m_totalEntities = snapshot.totalEntities;
+}
+
 const EntityVec& EntityManager::getEntities() {
     return m_entities;
 }
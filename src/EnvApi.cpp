@@ -0,0 +1,170 @@
+#include "EnvApi.h"
+#include "GameEngine.h"
+#include "Scene_Play.h"
+#include "ThreadPool.h"
+
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+static const char* ACTION_NAMES[] = { "LEFT", "RIGHT", "JUMP", "DOWN", "SHOOT" };
+static const size_t ACTION_COUNT = sizeof(ACTION_NAMES) / sizeof(ACTION_NAMES[0]);
+
+struct km_env
+{
+    std::unique_ptr<GameEngine> engine; // owns the assets every copy reads
+    std::vector<std::unique_ptr<Scene_Play>> scenes;
+    std::vector<uint32_t> held; // action mask of each copy's last step
+    std::vector<Action> actions; // END and START of every action bit
+    std::unique_ptr<ThreadPool> pool; // null when stepping on the caller
+
+    // arguments of the call being run, read by the pool's tasks, which
+    // only capture the env and a range so submitting them stays small
+    void (*task)(km_env*, size_t) = nullptr;
+    const uint32_t* stepActions = nullptr;
+    float* stepRewards = nullptr;
+    uint8_t* stepDones = nullptr;
+    float* observeBuffer = nullptr;
+};
+
+static void setHeld(km_env* env, size_t i, uint32_t mask) {
+    uint32_t changed = env->held[i] ^ mask;
+    for (size_t bit = 0; bit < ACTION_COUNT; bit++) {
+        if (changed & (1u << bit)) {
+            bool start = (mask & (1u << bit)) != 0;
+            env->scenes[i]->doAction(env->actions[bit * 2 + (start ? 1 : 0)]);
+        }
+    }
+    env->held[i] = mask;
+}
+
+static void stepOne(km_env* env, size_t i) {
+    Scene_Play& scene = *env->scenes[i];
+    setHeld(env, i, env->stepActions[i]);
+    int score = scene.score();
+    size_t restarts = scene.restartCount();
+    scene.simulate(1);
+    bool done = scene.restartCount() != restarts;
+    if (env->stepRewards) {
+        env->stepRewards[i] = done ? 0.0f : (float)(scene.score() - score);
+    }
+    if (env->stepDones) {
+        env->stepDones[i] = done ? 1 : 0;
+    }
+}
+
+static void observeOne(km_env* env, size_t i) {
+    env->scenes[i]->observe(
+        env->observeBuffer + i * km_observation_size(),
+        KM_OBS_GRID_WIDTH, KM_OBS_GRID_HEIGHT, KM_OBS_ENTITIES
+    );
+}
+
+// runs env->task for every copy, split into one range per worker
+static void forEachCopy(km_env* env, void (*task)(km_env*, size_t)) {
+    size_t count = env->scenes.size();
+    if (!env->pool) {
+        for (size_t i = 0; i < count; i++) {
+            task(env, i);
+        }
+        return;
+    }
+    env->task = task;
+    size_t workers = env->pool->size();
+    for (size_t w = 0; w < workers; w++) {
+        env->pool->submit([env, w]() {
+            size_t count = env->scenes.size();
+            size_t workers = env->pool->size();
+            for (size_t i = count * w / workers; i < count * (w + 1) / workers; i++) {
+                env->task(env, i);
+            }
+        });
+    }
+    env->pool->wait();
+}
+
+km_env* km_create_env(const char* assets, const char* level, int count, int threads) {
+    if (!assets || !level || count <= 0) {
+        return nullptr;
+    }
+    EngineConfig config;
+    config.backend = RenderBackend::RECORD;
+    config.simulate = true; // metadata only assets, no GL context needed
+    config.startScene = false; // only the copies below are ever stepped
+
+    // nothing thrown may cross into the caller, which need not be C++
+    std::unique_ptr<km_env> env;
+    try {
+        env = std::make_unique<km_env>();
+        env->engine = std::make_unique<GameEngine>(assets, config);
+        for (int i = 0; i < count; i++) {
+            env->scenes.push_back(std::make_unique<Scene_Play>(env->engine.get(), level));
+            if (!env->scenes.back()->isLoaded()) {
+                return nullptr;
+            }
+        }
+        env->held.assign(count, 0);
+        for (const char* name : ACTION_NAMES) {
+            env->actions.push_back(Action(name, "END"));
+            env->actions.push_back(Action(name, "START"));
+        }
+        if (count > 1 && threads != 1) {
+            env->pool = std::make_unique<ThreadPool>(threads < 0 ? 0 : threads);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Could not create an environment: " << e.what() << "\n";
+        return nullptr;
+    }
+    return env.release();
+}
+
+void km_destroy_env(km_env* env) {
+    delete env;
+}
+
+int km_env_count(const km_env* env) {
+    if (!env) {
+        return -1;
+    }
+    return (int)env->scenes.size();
+}
+
+size_t km_observation_size(void) {
+    return KM_OBS_PLAYER + KM_OBS_GRID_WIDTH * KM_OBS_GRID_HEIGHT + KM_OBS_ENTITIES * 3;
+}
+
+int km_reset(km_env* env, int index) {
+    if (!env || index < -1 || index >= (int)env->scenes.size()) {
+        return -1;
+    }
+    size_t first = index < 0 ? 0 : (size_t)index;
+    size_t last = index < 0 ? env->scenes.size() : first + 1;
+    for (size_t i = first; i < last; i++) {
+        // released before restarting, which keeps held keys
+        setHeld(env, i, 0);
+        env->scenes[i]->restart();
+    }
+    return 0;
+}
+
+int km_step(km_env* env, const uint32_t* actions, float* rewards, uint8_t* dones) {
+    if (!env || !actions) {
+        return -1;
+    }
+    env->stepActions = actions;
+    env->stepRewards = rewards;
+    env->stepDones = dones;
+    forEachCopy(env, stepOne);
+    return 0;
+}
+
+int km_observe(km_env* env, float* buffer) {
+    if (!env || !buffer) {
+        return -1;
+    }
+    env->observeBuffer = buffer;
+    forEachCopy(env, observeOne);
+    return 0;
+}
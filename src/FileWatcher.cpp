@@ -0,0 +1,204 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#if defined(__linux__)
+
+FileWatcher::FileWatcher() {}
+
+FileWatcher::~FileWatcher() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+bool FileWatcher::watch(const std::string& dir) {
+    // set up with the first directory, so a watcher nothing is added to
+    // costs nothing
+    if (!m_started) {
+        m_started = true;
+        m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_fd < 0) {
+            std::cerr << "Could not start watching files, hot reload is disabled\n";
+        }
+    }
+    if (m_fd < 0) {
+        return false;
+    }
+    std::error_code error;
+    std::string path = std::filesystem::canonical(dir, error).string();
+    if (error) {
+        return false;
+    }
+    for (auto& [wd, watched] : m_dirs) {
+        if (watched == path) {
+            return true;
+        }
+    }
+    // editors either write the file in place or write a temporary
+    // file and rename it over the original
+    int wd = inotify_add_watch(m_fd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+        return false;
+    }
+    m_dirs[wd] = path;
+    return true;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    std::vector<std::string> changed;
+    if (m_fd < 0) {
+        return changed;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t length = ::read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+        for (char* p = buffer; p < buffer + length;) {
+            const inotify_event* event = (const inotify_event*)p;
+            p += sizeof(inotify_event) + event->len;
+            auto dir = m_dirs.find(event->wd);
+            if (dir == m_dirs.end() || event->len == 0) {
+                continue;
+            }
+            std::string path = (std::filesystem::path(dir->second) / event->name).string();
+            if (std::find(changed.begin(), changed.end(), path) == changed.end()) {
+                changed.push_back(path);
+            }
+        }
+    }
+    return changed;
+}
+
+#elif defined(_WIN32)
+
+// one directory handle with a change read always in flight
+struct FileWatcher::Directory
+{
+    std::string path;
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    OVERLAPPED overlapped = {};
+    alignas(DWORD) char buffer[16 * 1024];
+
+    bool read() {
+        // a file written in place shows up as modified, one saved through
+        // a temporary file as renamed to its name
+        return ReadDirectoryChangesW(
+            handle, buffer, sizeof(buffer), FALSE,
+            FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+            nullptr, &overlapped, nullptr
+        ) != 0;
+    }
+};
+
+FileWatcher::FileWatcher() {}
+
+FileWatcher::~FileWatcher() {
+    for (auto& dir : m_dirs) {
+        // the pending read writes into the buffer until it is cancelled
+        DWORD bytes = 0;
+        CancelIoEx(dir->handle, &dir->overlapped);
+        GetOverlappedResult(dir->handle, &dir->overlapped, &bytes, TRUE);
+        CloseHandle(dir->overlapped.hEvent);
+        CloseHandle(dir->handle);
+    }
+}
+
+bool FileWatcher::watch(const std::string& dir) {
+    std::error_code error;
+    std::filesystem::path canonical = std::filesystem::canonical(dir, error);
+    if (error) {
+        return false;
+    }
+    std::string path = canonical.string();
+    for (auto& watched : m_dirs) {
+        if (watched->path == path) {
+            return true;
+        }
+    }
+
+    auto directory = std::make_unique<Directory>();
+    directory->path = path;
+    directory->handle = CreateFileW(
+        canonical.wstring().c_str(), FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr
+    );
+    if (directory->handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    directory->overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!directory->overlapped.hEvent || !directory->read()) {
+        if (directory->overlapped.hEvent) {
+            CloseHandle(directory->overlapped.hEvent);
+        }
+        CloseHandle(directory->handle);
+        return false;
+    }
+    m_dirs.push_back(std::move(directory));
+    return true;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    std::vector<std::string> changed;
+    for (auto& dir : m_dirs) {
+        DWORD bytes = 0;
+        if (!GetOverlappedResult(dir->handle, &dir->overlapped, &bytes, FALSE)) {
+            // ERROR_IO_INCOMPLETE, nothing changed since the last poll
+            continue;
+        }
+        // no bytes means the buffer overflowed and the changes were lost
+        for (DWORD offset = 0; bytes > 0;) {
+            const FILE_NOTIFY_INFORMATION* info =
+                (const FILE_NOTIFY_INFORMATION*)(dir->buffer + offset);
+            if (info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_ADDED
+                || info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                std::string path = (std::filesystem::path(dir->path) / name).string();
+                if (std::find(changed.begin(), changed.end(), path) == changed.end()) {
+                    changed.push_back(path);
+                }
+            }
+            if (info->NextEntryOffset == 0) {
+                break;
+            }
+            offset += info->NextEntryOffset;
+        }
+        ResetEvent(dir->overlapped.hEvent);
+        if (!dir->read()) {
+            std::cerr << "Stopped watching " << dir->path << "\n";
+        }
+    }
+    return changed;
+}
+
+#else
+
+FileWatcher::FileWatcher() {}
+
+FileWatcher::~FileWatcher() {}
+
+// no file notifications on this platform, hot reload silently does nothing
+bool FileWatcher::watch(const std::string&) {
+    return true;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    return {};
+}
+
+#endif
@@ -0,0 +1,321 @@
+#include "FrameCapture.h"
+
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/OpenGL.hpp>
+#include <SFML/Window/Context.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// pixel buffer objects are GL 2.1, past what the system headers declare
+// on every platform, so their entry points are looked up at runtime
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_READ_ONLY
+#define GL_READ_ONLY 0x88B8
+#endif
+
+typedef void (APIENTRY* GenBuffersFunc)(GLsizei, GLuint*);
+typedef void (APIENTRY* DeleteBuffersFunc)(GLsizei, const GLuint*);
+typedef void (APIENTRY* BindBufferFunc)(GLenum, GLuint);
+typedef void (APIENTRY* BufferDataFunc)(GLenum, std::ptrdiff_t, const void*, GLenum);
+typedef void* (APIENTRY* MapBufferFunc)(GLenum, GLenum);
+typedef GLboolean (APIENTRY* UnmapBufferFunc)(GLenum);
+
+static GenBuffersFunc glGenBuffersPtr = nullptr;
+static DeleteBuffersFunc glDeleteBuffersPtr = nullptr;
+static BindBufferFunc glBindBufferPtr = nullptr;
+static BufferDataFunc glBufferDataPtr = nullptr;
+static MapBufferFunc glMapBufferPtr = nullptr;
+static UnmapBufferFunc glUnmapBufferPtr = nullptr;
+
+// reads in flight, a screenshot and a recorded frame can share a frame
+static const size_t PIXEL_BUFFER_COUNT = 3;
+
+FrameCapture::FrameCapture(size_t slotCount)
+    : m_slots(slotCount)
+{
+    for (size_t i = 0; i < slotCount; i++) {
+        m_freeSlots.push_back(i);
+    }
+}
+
+FrameCapture::~FrameCapture() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_cv.notify_all();
+    // the encoder finishes writing everything still pending first
+    if (m_encoder.joinable()) {
+        m_encoder.join();
+    }
+}
+
+void FrameCapture::requestScreenshot() {
+    m_screenshotRequested = true;
+}
+
+void FrameCapture::startRecording(const std::string& dir, CaptureFormat format) {
+    std::filesystem::create_directories(dir);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_recordDir = dir;
+        m_recordFormat = format;
+        m_recordedFrames = 0;
+        m_droppedFrames = 0;
+    }
+    m_recording = true;
+    std::cout << "recording frames to " << dir << "\n";
+}
+
+void FrameCapture::stopRecording() {
+    if (!m_recording) {
+        return;
+    }
+    m_recording = false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::cout << "recorded " << m_recordedFrames << " frames, dropped "
+        << m_droppedFrames << "\n";
+}
+
+bool FrameCapture::isRecording() const {
+    return m_recording;
+}
+
+void FrameCapture::onFrameDrawn(sf::RenderTarget& target) {
+    m_frame++;
+    if (!m_readbacks.empty()) {
+        // reads started on earlier frames are done by now
+        target.setActive(true);
+        collect(false);
+    }
+
+    if (m_screenshotRequested) {
+        m_screenshotRequested = false;
+        capture(target, "test.png");
+    }
+
+    if (m_recording) {
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            char fileName[32];
+            std::snprintf(
+                fileName, sizeof(fileName), "frame_%06zu.%s",
+                m_recordedFrames + m_droppedFrames,
+                m_recordFormat == CaptureFormat::PNG ? "png" : "rgba"
+            );
+            path = (std::filesystem::path(m_recordDir) / fileName).string();
+        }
+        bool captured = capture(target, path);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (captured) {
+            m_recordedFrames++;
+        }
+        else {
+            m_droppedFrames++;
+        }
+    }
+}
+
+bool FrameCapture::capture(sf::RenderTarget& target, const std::string& path) {
+    size_t index;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_freeSlots.empty()) {
+            // the encoder is behind, skip this capture rather than wait
+            return false;
+        }
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+
+    // the slot's buffer is only reallocated when the target size changes
+    Slot& slot = m_slots[index];
+    slot.width = target.getSize().x;
+    slot.height = target.getSize().y;
+    slot.path = path;
+    slot.pixels.resize((size_t)slot.width * slot.height * 4);
+    target.setActive(true);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    if (!createPixelBuffers()) {
+        // no pixel buffers, read straight into the slot and wait for it
+        glReadPixels(
+            0, 0, slot.width, slot.height,
+            GL_RGBA, GL_UNSIGNED_BYTE, slot.pixels.data()
+        );
+        queue(index);
+        return true;
+    }
+
+    if (m_freePixelBuffers.empty()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_freeSlots.push_back(index);
+        return false;
+    }
+    size_t buffer = m_freePixelBuffers.back();
+    m_freePixelBuffers.pop_back();
+
+    // returns right away, the copy happens once the GPU gets to it
+    glBindBufferPtr(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[buffer]);
+    if (m_pixelBufferSizes[buffer] != slot.pixels.size()) {
+        glBufferDataPtr(GL_PIXEL_PACK_BUFFER, slot.pixels.size(), nullptr, GL_STREAM_READ);
+        m_pixelBufferSizes[buffer] = slot.pixels.size();
+    }
+    glReadPixels(0, 0, slot.width, slot.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBufferPtr(GL_PIXEL_PACK_BUFFER, 0);
+
+    Readback readback;
+    readback.slot = index;
+    readback.buffer = buffer;
+    readback.frame = m_frame;
+    m_readbacks.push_back(readback);
+    return true;
+}
+
+bool FrameCapture::createPixelBuffers() {
+    if (m_pixelBuffersTried) {
+        return !m_pixelBuffers.empty();
+    }
+    m_pixelBuffersTried = true;
+
+    auto load = [](const char* name, const char* arbName) {
+        sf::GlFunctionPointer function = sf::Context::getFunction(name);
+        return function ? function : sf::Context::getFunction(arbName);
+    };
+    glGenBuffersPtr = (GenBuffersFunc)load("glGenBuffers", "glGenBuffersARB");
+    glDeleteBuffersPtr = (DeleteBuffersFunc)load("glDeleteBuffers", "glDeleteBuffersARB");
+    glBindBufferPtr = (BindBufferFunc)load("glBindBuffer", "glBindBufferARB");
+    glBufferDataPtr = (BufferDataFunc)load("glBufferData", "glBufferDataARB");
+    glMapBufferPtr = (MapBufferFunc)load("glMapBuffer", "glMapBufferARB");
+    glUnmapBufferPtr = (UnmapBufferFunc)load("glUnmapBuffer", "glUnmapBufferARB");
+    if (!glGenBuffersPtr || !glDeleteBuffersPtr || !glBindBufferPtr
+        || !glBufferDataPtr || !glMapBufferPtr || !glUnmapBufferPtr) {
+        std::cerr << "No pixel buffer objects, frames are captured synchronously\n";
+        return false;
+    }
+
+    m_pixelBuffers.resize(PIXEL_BUFFER_COUNT);
+    glGenBuffersPtr((GLsizei)PIXEL_BUFFER_COUNT, m_pixelBuffers.data());
+    m_pixelBufferSizes.assign(PIXEL_BUFFER_COUNT, 0);
+    for (size_t i = 0; i < PIXEL_BUFFER_COUNT; i++) {
+        m_freePixelBuffers.push_back(i);
+    }
+    return true;
+}
+
+void FrameCapture::collect(bool all) {
+    while (!m_readbacks.empty() && (all || m_readbacks.front().frame < m_frame)) {
+        Readback readback = m_readbacks.front();
+        m_readbacks.pop_front();
+        Slot& slot = m_slots[readback.slot];
+
+        glBindBufferPtr(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[readback.buffer]);
+        const void* pixels = glMapBufferPtr(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        bool mapped = pixels != nullptr;
+        if (mapped) {
+            std::memcpy(slot.pixels.data(), pixels, slot.pixels.size());
+            glUnmapBufferPtr(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBufferPtr(GL_PIXEL_PACK_BUFFER, 0);
+        m_freePixelBuffers.push_back(readback.buffer);
+
+        if (mapped) {
+            queue(readback.slot);
+        }
+        else {
+            std::cerr << "Could not map captured frame " << slot.path << "!\n";
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_freeSlots.push_back(readback.slot);
+        }
+    }
+}
+
+void FrameCapture::queue(size_t index) {
+    // started with the first captured frame, most runs never take one
+    if (!m_encoder.joinable()) {
+        m_encoder = std::thread(&FrameCapture::run, this);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back(index);
+    }
+    m_cv.notify_all();
+}
+
+void FrameCapture::finish(sf::RenderTarget& target) {
+    if (m_pixelBuffers.empty()) {
+        return;
+    }
+    target.setActive(true);
+    collect(true);
+    glDeleteBuffersPtr((GLsizei)m_pixelBuffers.size(), m_pixelBuffers.data());
+    m_pixelBuffers.clear();
+    m_pixelBufferSizes.clear();
+    m_freePixelBuffers.clear();
+    m_pixelBuffersTried = false;
+}
+
+void FrameCapture::encode(Slot& slot) {
+    // GL returns the bottom row first
+    size_t stride = (size_t)slot.width * 4;
+    std::vector<unsigned char> row(stride);
+    for (size_t y = 0; y < slot.height / 2; y++) {
+        unsigned char* top = slot.pixels.data() + y * stride;
+        unsigned char* bottom = slot.pixels.data() + (slot.height - 1 - y) * stride;
+        std::memcpy(row.data(), top, stride);
+        std::memcpy(top, bottom, stride);
+        std::memcpy(bottom, row.data(), stride);
+    }
+
+    if (slot.path.ends_with(".rgba")) {
+        std::ofstream file(slot.path, std::ios::binary);
+        file.write((const char*)slot.pixels.data(), slot.pixels.size());
+
+        auto info = std::filesystem::path(slot.path).parent_path() / "info.txt";
+        if (!std::filesystem::exists(info)) {
+            std::ofstream(info) << slot.width << " " << slot.height << "\n";
+        }
+        return;
+    }
+
+    sf::Image image;
+    image.create(slot.width, slot.height, slot.pixels.data());
+    if (!image.saveToFile(slot.path)) {
+        std::cerr << "Could not save frame " << slot.path << "!\n";
+    }
+    else if (slot.path == "test.png") {
+        std::cout << "screenshot saved to " << slot.path << std::endl;
+    }
+}
+
+void FrameCapture::run() {
+    while (true) {
+        size_t index;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return !m_pending.empty() || !m_running; });
+            if (m_pending.empty()) {
+                break;
+            }
+            index = m_pending.front();
+            m_pending.pop_front();
+        }
+
+        encode(m_slots[index]);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_freeSlots.push_back(index);
+        }
+    }
+}
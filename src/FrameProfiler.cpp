@@ -0,0 +1,77 @@
+#include "FrameProfiler.h"
+
+#include <algorithm>
+
+// unset until a thread changes it, which stands for instance()
+static thread_local bool t_profilerSet = false;
+static thread_local FrameProfiler* t_profiler = nullptr;
+
+FrameProfiler& FrameProfiler::instance() {
+    static FrameProfiler profiler;
+    return profiler;
+}
+
+FrameProfiler* FrameProfiler::threadProfiler() {
+    return t_profilerSet ? t_profiler : &instance();
+}
+
+void FrameProfiler::setThreadProfiler(FrameProfiler* profiler) {
+    t_profiler = profiler;
+    t_profilerSet = true;
+}
+
+const char* FrameProfiler::sectionName(ProfileSection section) {
+    switch (section) {
+        case ProfileSection::FRAME: return "frame";
+        case ProfileSection::USER_INPUT: return "input";
+        case ProfileSection::ENTITY_UPDATE: return "entities";
+        case ProfileSection::MOVEMENT: return "movement";
+        case ProfileSection::LIFESPAN: return "lifespan";
+        case ProfileSection::COLLISION: return "collision";
+        case ProfileSection::STREAMING: return "streaming";
+        case ProfileSection::ANIMATION: return "animation";
+        case ProfileSection::RENDER: return "render";
+        case ProfileSection::DRAW: return "draw";
+        case ProfileSection::DISPLAY: return "display";
+        case ProfileSection::COUNT: break;
+    }
+    return "unknown";
+}
+
+void FrameProfiler::add(ProfileSection section, std::int64_t nanoseconds) {
+    m_current[(size_t)section].fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void FrameProfiler::endFrame() {
+    size_t slot = m_frames % WINDOW;
+    for (size_t i = 0; i < SECTION_COUNT; i++) {
+        m_samples[i][slot] = m_current[i].exchange(0, std::memory_order_relaxed);
+    }
+    m_frames++;
+}
+
+size_t FrameProfiler::frames() const {
+    return std::min(m_frames, WINDOW);
+}
+
+FrameProfiler::Stats FrameProfiler::stats(ProfileSection section) const {
+    Stats stats;
+    size_t count = frames();
+    if (count == 0) {
+        return stats;
+    }
+    // sorted on the stack, the overlay asks every frame
+    std::array<std::int64_t, WINDOW> sorted;
+    const auto& samples = m_samples[(size_t)section];
+    std::copy(samples.begin(), samples.begin() + count, sorted.begin());
+    std::sort(sorted.begin(), sorted.begin() + count);
+
+    std::int64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += sorted[i];
+    }
+    stats.min = sorted[0] / 1e6;
+    stats.avg = (double)sum / count / 1e6;
+    stats.p99 = sorted[std::min(count - 1, count * 99 / 100)] / 1e6;
+    return stats;
+}
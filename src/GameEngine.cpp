@@ -1,20 +1,113 @@
 #include "GameEngine.h"
 #include "Assets.h"
+#include "FrameProfiler.h"
 #include "Scene_Menu.h"
+#include "Scene_Play.h"
+#include "ThreadPool.h"
+#include "TraceRecorder.h"
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
 #include <string>
+#include <thread>
 
-GameEngine::GameEngine(const std::string& path) {
+GameEngine::GameEngine(const std::string& path, const EngineConfig& config)
+    : m_config(config)
+{
     init(path);
 }
 
+GameEngine::~GameEngine() {
+    if (m_renderThread) {
+        m_renderThread->stop();
+    }
+}
+
 void GameEngine::init(const std::string& path) {
-    m_assets.loadFromFile(path);
-    m_window.create(sf::VideoMode(1280, 768), "Knockoff Mario");
-    m_window.setFramerateLimit(60);
+    // started first, so asset loading shows up on the timeline
+    if (!m_config.trace.empty()) {
+        TraceRecorder::instance().start();
+        TraceRecorder::instance().setThreadName("main");
+#ifndef KM_TRACE
+        std::cerr << "Built without KM_TRACE or KM_PROFILE, the trace only has "
+            "asset loads and counters\n";
+#endif
+    }
+    LoadTimer initTimer;
+    if (!m_config.inputs.empty()) {
+        if (!m_inputs.load(m_config.inputs)) {
+            exit(-1);
+        }
+        m_scripted = true;
+    }
+    m_assets.setProfiler(&m_loadProfiler);
+    m_assets.setLazyLoading(m_config.lazyAssets);
+    m_assets.setTextureBudget(m_config.textureBudget);
+    // simulated runs and the null renderer draw nothing, so textures are
+    // never needed and neither is a GL context
+    m_assets.setMetadataOnly(m_config.simulate || m_config.backend == RenderBackend::RECORD);
+    if (path.ends_with(".kpack")) {
+        m_assets.loadFromPack(path);
+    }
+    else {
+        m_assets.loadFromFile(path);
+    }
 
-    changeScene("MENU", std::make_shared<Scene_Menu>(this));
+    if (m_config.hotReload) {
+        for (auto& file : m_assets.sourceFiles()) {
+            watchFile(file);
+        }
+    }
+
+    LoadTimer windowTimer;
+    if (m_config.backend == RenderBackend::WINDOW) {
+        m_window.create(sf::VideoMode(m_size.x, m_size.y), "Knockoff Mario");
+        m_window.setFramerateLimit(60);
+        m_loadProfiler.add(LoadPhase::WINDOW, "window", windowTimer.seconds());
+    }
+    else if (m_config.backend == RenderBackend::TEXTURE) {
+        // needs a GL context but no display, a software GL driver
+        // (e.g. mesa llvmpipe) is enough on CI machines
+        m_renderTexture = std::make_unique<sf::RenderTexture>();
+        if (!m_renderTexture->create(m_size.x, m_size.y)) {
+            std::cerr << "Could not create offscreen render texture!\n";
+            exit(-1);
+        }
+        m_loadProfiler.add(LoadPhase::WINDOW, "render texture", windowTimer.seconds());
+    }
+
+    if (m_config.renderThread && m_config.backend == RenderBackend::WINDOW) {
+        m_renderThread = std::make_unique<RenderThread>(
+            m_window,
+            [this](RenderFrame& frame) { drawFrame(frame); }
+        );
+    }
+
+    if (!m_config.startScene) {
+        // the caller makes and steps its own scenes
+    }
+    else if (!m_config.level.empty()) {
+        auto scene = std::make_shared<Scene_Play>(this, m_config.level);
+        if (!scene->isLoaded()) {
+            exit(-1);
+        }
+        changeScene("PLAY", scene);
+        if (!m_config.recordInputs.empty()) {
+            m_inputRecorder.start(m_config.recordInputs, m_config.level);
+        }
+    }
+    else {
+        changeScene("MENU", std::make_shared<Scene_Menu>(this));
+    }
+    m_loadProfiler.setInitSeconds(initTimer.seconds());
+}
+
+bool GameEngine::isCurrentScene(const Scene* scene) const {
+    auto it = m_sceneMap.find(m_currentScene);
+    return it != m_sceneMap.end() && it->second.get() == scene;
 }
 
 std::shared_ptr<Scene> GameEngine::currentScene() {
@@ -22,22 +115,275 @@ std::shared_ptr<Scene> GameEngine::currentScene() {
 }
 
 bool GameEngine::isRunning() {
-    return m_running && m_window.isOpen();
+    if (m_config.frames > 0 && m_frameCount >= m_config.frames) {
+        return false;
+    }
+    return m_running && (isHeadless() || m_window.isOpen());
+}
+
+bool GameEngine::isHeadless() const {
+    return m_config.backend != RenderBackend::WINDOW;
+}
+
+int GameEngine::exitCode() const {
+    return m_goldenFailures == 0 ? 0 : 1;
 }
 
 sf::RenderWindow& GameEngine::window() {
     return m_window;
 }
 
+sf::Vector2u GameEngine::size() const {
+    return isHeadless() ? m_size : m_window.getSize();
+}
+
+RenderFrame& GameEngine::frame() {
+    return m_renderThread ? m_renderThread->backFrame() : m_frame;
+}
+
 void GameEngine::run() {
-    while (isRunning()) {
-        sUserInput();
-        update(); 
+    if (!m_config.captureDir.empty()) {
+        m_capture.startRecording(m_config.captureDir, m_config.captureFormat);
+    }
+    if (m_renderThread) {
+        m_renderThread->start();
+    }
+
+    // with a render thread the frame limiter no longer paces the
+    // simulation, so tick at the same rate ourselves
+    const auto tickTime = std::chrono::microseconds(1000000 / 60);
+    auto nextTick = std::chrono::steady_clock::now();
+
+    if (m_config.simulate && m_config.instances > 1) {
+        simulateInstances();
+    }
+    else if (m_config.simulate) {
+        simulate();
+    }
+    while (isRunning() && !m_config.simulate) {
+        {
+            PROFILE_SCOPE(FRAME);
+            sUserInput();
+            sHotReload();
+            if (m_scripted) {
+                m_inputs.apply(*currentScene(), m_frameCount);
+            }
+            auto frameStart = std::chrono::steady_clock::now();
+            update(); 
+            m_inputRecorder.endTick();
+            traceCounters();
+            present();
+            m_frameSeconds += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - frameStart
+            ).count();
+            m_frameCount++;
+        }
+        PROFILE_END_FRAME();
+
+        if (m_renderThread) {
+            nextTick += tickTime;
+            auto now = std::chrono::steady_clock::now();
+            if (nextTick < now) {
+                nextTick = now;
+            }
+            std::this_thread::sleep_until(nextTick);
+        }
+    }
+
+    if (m_renderThread) {
+        m_renderThread->stop();
+    }
+    // a scene still loading joins its worker here, before the profile
+    // it adds to is reported
+    m_sceneMap.clear();
+    // frames still being read back are copied out while the context lives
+    if (m_renderTexture) {
+        m_capture.finish(*m_renderTexture);
+    }
+    else if (m_window.isOpen()) {
+        m_capture.finish(m_window);
+    }
+    m_window.close();
+    m_capture.stopRecording();
+    m_inputRecorder.stop();
+
+    if (isHeadless() && !m_config.simulate) {
+        printRenderStats();
+    }
+    if (m_config.loadProfile) {
+        m_loadProfiler.printSummary(std::cout);
+    }
+    if (!m_config.loadProfileJson.empty()) {
+        m_loadProfiler.writeJson(m_config.loadProfileJson);
+    }
+    if (!m_config.trace.empty()) {
+        TraceRecorder::instance().write(m_config.trace);
+    }
+}
+
+void GameEngine::present() {
+    if (m_renderThread) {
+        m_renderThread->publish();
+    }
+    else if (m_config.backend == RenderBackend::TEXTURE) {
+        m_frame.draw(*m_renderTexture, m_renderStats);
+        m_renderTexture->display();
+        m_capture.onFrameDrawn(*m_renderTexture);
+        if (m_config.dumpEvery > 0 && m_frameCount % m_config.dumpEvery == 0) {
+            dumpFrame();
+        }
+    }
+    else if (m_config.backend == RenderBackend::RECORD) {
+        m_frame.record(m_renderStats);
+    }
+    else {
+        drawFrame(m_frame);
+        PROFILE_SCOPE(DISPLAY);
         m_window.display();
     }
 }
 
+// runs on whichever thread owns the window's GL context
+void GameEngine::drawFrame(RenderFrame& frame) {
+    PROFILE_SCOPE(DRAW);
+    size_t batches = m_renderStats.batches;
+    size_t commands = m_renderStats.commands;
+    frame.draw(m_window, m_renderStats);
+    m_capture.onFrameDrawn(m_window);
+
+    TraceRecorder& trace = TraceRecorder::instance();
+    if (trace.isRecording()) {
+        trace.counter("draw calls", "batches", m_renderStats.batches - batches);
+        trace.counter("draw calls", "sprites", m_renderStats.commands - commands);
+    }
+}
+
+// entity counts of the current scene, one line per tag
+void GameEngine::traceCounters() {
+    TraceRecorder& trace = TraceRecorder::instance();
+    if (!trace.isRecording()) {
+        return;
+    }
+    for (auto& [tag, entities] : currentScene()->getEntityManager().getEntityMap()) {
+        trace.counter("entities", tag, entities.size());
+    }
+}
+
+void GameEngine::dumpFrame() {
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "frame_%06zu.png", m_frameCount);
+
+    sf::Image image = m_renderTexture->getTexture().copyToImage();
+    std::filesystem::create_directories(m_config.dumpDir);
+    std::string path = (std::filesystem::path(m_config.dumpDir) / fileName).string();
+    if (!image.saveToFile(path)) {
+        std::cerr << "Could not save frame " << path << "!\n";
+    }
+
+    if (!m_config.goldenDir.empty() && !compareWithGolden(image, fileName)) {
+        m_goldenFailures++;
+    }
+}
+
+bool GameEngine::compareWithGolden(const sf::Image& image, const std::string& fileName) {
+    std::string path = (std::filesystem::path(m_config.goldenDir) / fileName).string();
+    sf::Image golden;
+    if (!golden.loadFromFile(path)) {
+        std::cerr << "Missing golden image " << path << "!\n";
+        return false;
+    }
+    if (golden.getSize() != image.getSize()) {
+        std::cerr << "Golden image " << path << " has a different size!\n";
+        return false;
+    }
+
+    // a pixel differs when any channel is further apart than the tolerance
+    const sf::Uint8* a = image.getPixelsPtr();
+    const sf::Uint8* b = golden.getPixelsPtr();
+    size_t pixels = image.getSize().x * image.getSize().y;
+    size_t differing = 0;
+    for (size_t i = 0; i < pixels; i++) {
+        for (size_t c = 0; c < 4; c++) {
+            if (std::abs(a[i * 4 + c] - b[i * 4 + c]) > m_config.tolerance) {
+                differing++;
+                break;
+            }
+        }
+    }
+    if (differing > 0) {
+        std::cerr << fileName << ": " << differing << " of " << pixels
+            << " pixels differ from the golden image\n";
+        return false;
+    }
+    return true;
+}
+
+void GameEngine::printRenderStats() const {
+    size_t frames = std::max<size_t>(m_renderStats.frames, 1);
+    std::cout << "frames:           " << m_frameCount << "\n"
+        << "ms per frame:     " << m_frameSeconds * 1000.0 / frames << "\n"
+        << "commands / frame: " << (double)m_renderStats.commands / frames << "\n"
+        << "batches / frame:  " << (double)m_renderStats.batches / frames << "\n"
+        << "lines / frame:    " << (double)m_renderStats.lines / frames << "\n"
+        << "texts / frame:    " << (double)m_renderStats.texts / frames << "\n";
+    if (!m_config.goldenDir.empty()) {
+        std::cout << "golden mismatches: " << m_goldenFailures << "\n";
+    }
+}
+
+void GameEngine::simulate() {
+    auto start = std::chrono::steady_clock::now();
+    size_t ticks = currentScene()->simulate(m_config.frames, m_scripted ? &m_inputs : nullptr);
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+    m_frameCount += ticks;
+
+    std::cout << "ticks:            " << ticks << "\n"
+        << "seconds:          " << seconds << "\n"
+        << "ticks / second:   " << ticks / std::max(seconds, 1e-9) << "\n"
+        << "us per tick:      " << seconds * 1e6 / std::max<size_t>(ticks, 1) << "\n";
+}
+
+void GameEngine::simulateInstances() {
+    // every instance has its own entities, streamer and input cursor;
+    // the engine and its assets are only read while they run
+    ThreadPool pool(m_config.jobs);
+    std::vector<size_t> ticks(m_config.instances, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < m_config.instances; i++) {
+        pool.submit([this, &ticks, i]() {
+            Scene_Play scene(this, m_config.level);
+            InputScript inputs = m_inputs;
+            inputs.rewind();
+            ticks[i] = scene.simulate(m_config.frames, m_scripted ? &inputs : nullptr);
+        });
+    }
+    pool.wait();
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+
+    size_t total = 0;
+    for (size_t t : ticks) {
+        total += t;
+    }
+    m_frameCount += total;
+    seconds = std::max(seconds, 1e-9);
+    std::cout << "instances:        " << m_config.instances << "\n"
+        << "threads:          " << pool.size() << "\n"
+        << "ticks:            " << total << "\n"
+        << "seconds:          " << seconds << "\n"
+        << "ticks / second:   " << total / seconds << "\n"
+        << "per thread:       " << total / seconds / pool.size() << "\n";
+}
+
 void GameEngine::sUserInput() {
+    if (isHeadless()) {
+        return;
+    }
+    PROFILE_SCOPE(USER_INPUT);
+
     sf::Event event;
     while (m_window.pollEvent(event)) {
         if (event.type == sf::Event::Closed) {
@@ -46,15 +392,22 @@ void GameEngine::sUserInput() {
 
         if (event.type == sf::Event::KeyPressed) {
             if (event.key.code == sf::Keyboard::X) {
-                std::cout << "screenshot saved to " << "test.png" << std::endl;
-                sf::Texture texture;
-                texture.create(m_window.getSize().x, m_window.getSize().y);
-                texture.update(m_window);
-
-                if (texture.copyToImage().saveToFile("test.png")) {
-                    std::cout << "screenshot saved successfully!\n";
+                // read back after the next frame is drawn and saved
+                // on the capture thread
+                m_capture.requestScreenshot();
+            }
+            else if (event.key.code == sf::Keyboard::V) {
+                if (m_capture.isRecording()) {
+                    m_capture.stopRecording();
+                }
+                else {
+                    m_capture.startRecording("capture", CaptureFormat::PNG);
                 }
             }
+            else if (event.key.code == sf::Keyboard::F12 && !m_config.trace.empty()) {
+                // everything so far, recording carries on
+                TraceRecorder::instance().write(m_config.trace);
+            }
         }
 
         if (event.type == sf::Event::KeyPressed || 
@@ -66,15 +419,42 @@ void GameEngine::sUserInput() {
                 continue;
             }
 
+            // while replaying, the keyboard does not play along
+            if (m_scripted) {
+                continue;
+            }
+
             // determine start or end action by whether it was key press or release
             const std::string actionType = 
                 (event.type == sf::Event::KeyPressed) ? "START" : "END";
 
-            currentScene()->doAction(
-                Action(currentScene()->getActionMap().at(event.key.code)
-                    , actionType)
-            );
+            Action action(currentScene()->getActionMap().at(event.key.code), actionType);
+            m_inputRecorder.record(action);
+            currentScene()->doAction(action);
+        }
+    }
+}
+
+void GameEngine::sHotReload() {
+    // changes are picked up once the load is done, the watcher queues them
+    if (currentScene()->isLoading()) {
+        return;
+    }
+    std::vector<std::string> changed = m_watcher.poll();
+    if (changed.empty()) {
+        return;
+    }
+
+    // textures are swapped in place, which must not happen while the
+    // render thread is drawing with them
+    if (m_renderThread) {
+        m_renderThread->sync();
+    }
+    for (auto& path : changed) {
+        if (m_assets.reload(path)) {
+            std::cout << "reloaded " << path << "\n";
         }
+        currentScene()->onFileChanged(path);
     }
 }
 
@@ -88,14 +468,44 @@ void GameEngine::changeScene(
 }
 
 void GameEngine::quit() {
+    // the window is closed by run() once the render thread has stopped
     m_running = false;
-    m_window.close();
 }
 
 void GameEngine::update() {
+    RenderFrame& f = frame();
+    f.clear();
+    f.view = sf::View(sf::FloatRect(0, 0, (float)size().x, (float)size().y));
     currentScene()->update();
 }
 
 const Assets& GameEngine::assets() const {
     return m_assets;
 }
+
+LoadProfiler& GameEngine::loadProfiler() {
+    return m_loadProfiler;
+}
+
+void GameEngine::requireAssets(const std::vector<AssetId>& animations) {
+    // a frame still queued on the render thread may use a texture that
+    // is about to be evicted
+    if (m_renderThread) {
+        m_renderThread->sync();
+    }
+    m_assets.require(animations);
+}
+
+void GameEngine::watchFile(const std::string& path) {
+    // simulated runs never poll the watcher, and their pooled instances
+    // would all get here at once from different threads
+    if (!m_config.hotReload || m_config.simulate) {
+        return;
+    }
+    // watching the directory also catches editors that save by
+    // renaming a new file over the old one
+    std::string dir = std::filesystem::path(path).parent_path().string();
+    if (!m_watcher.watch(dir.empty() ? "." : dir)) {
+        std::cerr << "Could not watch " << path << " for changes\n";
+    }
+}
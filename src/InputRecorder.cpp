@@ -0,0 +1,95 @@
+#include "InputRecorder.h"
+#include "FixedName.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+void InputRecorder::start(const std::string& path, const std::string& level) {
+    m_path = path;
+    m_level = level;
+    m_names.clear();
+    m_events.clear();
+    m_eventCount = 0;
+    m_tick = 0;
+    m_lastEventTick = 0;
+    m_recording = true;
+}
+
+bool InputRecorder::isRecording() const {
+    return m_recording;
+}
+
+void InputRecorder::record(const Action& action) {
+    if (!m_recording) {
+        return;
+    }
+    auto it = std::find(m_names.begin(), m_names.end(), action.name());
+    size_t index = it - m_names.begin();
+    if (it == m_names.end()) {
+        if (m_names.size() == INPUT_MAX_ACTIONS
+            || action.name().size() >= INPUT_NAME_SIZE) {
+            std::cerr << "Could not record action " << action.name() << "!\n";
+            return;
+        }
+        m_names.push_back(action.name());
+    }
+
+    // 7 bits per byte, the high bit says another byte follows
+    size_t delta = m_tick - m_lastEventTick;
+    while (delta >= 0x80) {
+        m_events.push_back((unsigned char)(delta | 0x80));
+        delta >>= 7;
+    }
+    m_events.push_back((unsigned char)delta);
+    m_events.push_back((unsigned char)(index << 1 | (action.type() == "START" ? 1 : 0)));
+    m_lastEventTick = m_tick;
+    m_eventCount++;
+}
+
+void InputRecorder::endTick() {
+    if (m_recording) {
+        m_tick++;
+    }
+}
+
+bool InputRecorder::stop() {
+    if (!m_recording) {
+        return true;
+    }
+    m_recording = false;
+
+    InputHeader header = {};
+    std::memcpy(header.magic, "KINP", 4);
+    header.version = INPUT_VERSION;
+    header.tickCount = (std::uint32_t)m_tick;
+    header.eventCount = (std::uint32_t)m_eventCount;
+    header.actionCount = (std::uint32_t)m_names.size();
+    // replaying needs the whole path, a cut one would name another file
+    if (!copyName(header.level, m_level)) {
+        std::cerr << "Level path " << m_level << " is too long for an input recording!\n";
+        return false;
+    }
+
+    std::ofstream file(m_path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Could not write input recording " << m_path << "!\n";
+        return false;
+    }
+    file.write((const char*)&header, sizeof(header));
+    for (auto& name : m_names) {
+        // names that do not fit were never recorded
+        char padded[INPUT_NAME_SIZE];
+        copyName(padded, name);
+        file.write(padded, INPUT_NAME_SIZE);
+    }
+    file.write((const char*)m_events.data(), m_events.size());
+    if (!file) {
+        std::cerr << "Could not write input recording " << m_path << "!\n";
+        return false;
+    }
+    std::cout << "recorded " << m_tick << " ticks and " << m_eventCount
+        << " actions into " << m_path << "\n";
+    return true;
+}
@@ -0,0 +1,138 @@
+#include "InputScript.h"
+#include "InputRecorder.h"
+#include "MappedFile.h"
+#include "Scene.h"
+#include "Tokenizer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+
+bool InputScript::load(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Could not load input script " << path << "!\n";
+        return false;
+    }
+    m_actions.clear();
+    m_next = 0;
+    m_tickCount = 0;
+    m_level.clear();
+    if (file.size() >= 4 && std::memcmp(file.data(), "KINP", 4) == 0) {
+        return readRecording(path, file.data(), file.size());
+    }
+    return readText(path, (const char*)file.data(), file.size());
+}
+
+bool InputScript::readText(const std::string& path, const char* data, size_t size) {
+    Tokenizer tokens(path, data, size);
+    std::string_view tick;
+    while (tokens.next(tick)) {
+        int value = 0;
+        auto [end, error] = std::from_chars(tick.data(), tick.data() + tick.size(), value);
+        if (error != std::errc() || end != tick.data() + tick.size() || value < 0) {
+            return tokens.error("expected a tick, got '" + std::string(tick) + "'");
+        }
+        std::string_view name, type;
+        if (!tokens.read(name, "an action name") || !tokens.read(type, "START or END")) {
+            return false;
+        }
+        if (type != "START" && type != "END") {
+            return tokens.error("expected START or END, got '" + std::string(type) + "'");
+        }
+        m_actions.push_back({ (size_t)value, Action(std::string(name), std::string(type)) });
+    }
+    std::stable_sort(m_actions.begin(), m_actions.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; }
+    );
+    return true;
+}
+
+bool InputScript::readRecording(
+    const std::string& path,
+    const unsigned char* data,
+    size_t size
+) {
+    auto corrupt = [&path]() {
+        std::cerr << "Input recording " << path << " is corrupt!\n";
+        return false;
+    };
+    if (size < sizeof(InputHeader)) {
+        return corrupt();
+    }
+    InputHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.version != INPUT_VERSION) {
+        std::cerr << "Input recording " << path << " has version " << header.version
+            << ", expected " << INPUT_VERSION << "!\n";
+        return false;
+    }
+    size_t namesSize = (size_t)header.actionCount * INPUT_NAME_SIZE;
+    if (header.actionCount > INPUT_MAX_ACTIONS || size - sizeof(header) < namesSize) {
+        return corrupt();
+    }
+    m_tickCount = header.tickCount;
+    m_level.assign(header.level, strnlen(header.level, INPUT_LEVEL_SIZE));
+
+    // every event is one of these, so they are built once
+    std::vector<Action> actions;
+    const char* names = (const char*)data + sizeof(header);
+    for (size_t i = 0; i < header.actionCount; i++) {
+        std::string name(names + i * INPUT_NAME_SIZE, strnlen(names + i * INPUT_NAME_SIZE, INPUT_NAME_SIZE));
+        actions.push_back(Action(name, "END"));
+        actions.push_back(Action(name, "START"));
+    }
+
+    const unsigned char* pos = data + sizeof(header) + namesSize;
+    const unsigned char* end = data + size;
+    // every event takes at least two bytes, so a count the file cannot
+    // hold is rejected before it is used to size anything
+    if (header.eventCount > (size_t)(end - pos) / 2) {
+        return corrupt();
+    }
+    size_t tick = 0;
+    m_actions.reserve(header.eventCount);
+    for (size_t i = 0; i < header.eventCount; i++) {
+        size_t delta = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (pos == end || shift > 56) {
+                return corrupt();
+            }
+            unsigned char byte = *pos++;
+            delta |= (size_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        if (pos == end || *pos >= actions.size()) {
+            return corrupt();
+        }
+        tick += delta;
+        m_actions.push_back({ tick, actions[*pos++] });
+    }
+    return true;
+}
+
+void InputScript::rewind() {
+    m_next = 0;
+}
+
+void InputScript::apply(Scene& scene, size_t tick) {
+    while (m_next < m_actions.size() && m_actions[m_next].first <= tick) {
+        scene.doAction(m_actions[m_next].second);
+        m_next++;
+    }
+}
+
+size_t InputScript::tickCount() const {
+    return m_tickCount;
+}
+
+const std::string& InputScript::level() const {
+    return m_level;
+}
+
+size_t InputScript::size() const {
+    return m_actions.size();
+}
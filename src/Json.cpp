@@ -0,0 +1,26 @@
+#include "Json.h"
+
+#include <cstdio>
+
+std::string jsonString(std::string_view text) {
+    std::string escaped = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\r': escaped += "\\r"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char code[8];
+                    std::snprintf(code, sizeof(code), "\\u%04x", (unsigned)c);
+                    escaped += code;
+                }
+                else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped + "\"";
+}
@@ -0,0 +1,290 @@
+#include "LevelFile.h"
+#include "FixedName.h"
+#include "Tokenizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string_view>
+#include <tuple>
+
+namespace {
+
+// names of a mapped level are read as C strings
+bool isTerminated(const char (&name)[LEVEL_NAME_SIZE]) {
+    return std::memchr(name, '\0', LEVEL_NAME_SIZE) != nullptr;
+}
+
+}
+
+bool LevelFile::open(const std::string& path, LoadProfiler* profiler) {
+    if (path.ends_with(".klvl")) {
+        LoadTimer timer;
+        if (!mapBinary(path)) {
+            return false;
+        }
+        if (profiler) {
+            profiler->add(LoadPhase::LEVEL_PARSE, path, timer.seconds(), m_file.size(), tileCount());
+        }
+        return true;
+    }
+    return readText(path, profiler);
+}
+
+bool LevelFile::readText(const std::string& path, LoadProfiler* profiler) {
+    // the text is only needed while parsing, names are copied out of it
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Could not load level " << path << "!\n";
+        return false;
+    }
+    Tokenizer tokens(path, (const char*)file.data(), file.size());
+
+    std::memset(&m_textHeader, 0, sizeof(m_textHeader));
+    std::memcpy(m_textHeader.magic, "KLVL", 4);
+    m_textHeader.version = LEVEL_VERSION;
+    m_textLayers.clear();
+    m_textTypes.clear();
+    m_textTiles.clear();
+
+    // every distinct (kind, animation, layer) becomes one type
+    std::map<std::tuple<LevelTileKind, std::string_view, std::uint32_t>, std::uint32_t> typeIds;
+    // parse time and count per line kind, only measured when profiling
+    std::map<std::string_view, std::pair<double, size_t>> lineTimes;
+
+    std::string_view head;
+    while (tokens.next(head)) {
+        std::chrono::steady_clock::time_point lineStart;
+        if (profiler) {
+            lineStart = std::chrono::steady_clock::now();
+        }
+
+        if (head == "Tile" || head == "Dec") {
+            std::string_view name;
+            LevelTile tile;
+            if (!tokens.read(name, "an animation name")
+                || !tokens.read(tile.x, "a grid x")
+                || !tokens.read(tile.y, "a grid y")) {
+                return false;
+            }
+            LevelTileKind kind = head == "Tile"
+                ? LevelTileKind::TILE : LevelTileKind::DECORATION;
+            if (kind == LevelTileKind::DECORATION && m_textLayers.empty()) {
+                // decorations before any Layer line go into a default layer
+                LevelLayer layer;
+                copyName(layer.name, "Dec");
+                layer.parallax = 1.0f;
+                layer.reserved = 0;
+                m_textLayers.push_back(layer);
+            }
+            std::uint32_t layer = kind == LevelTileKind::DECORATION
+                ? (std::uint32_t)m_textLayers.size() - 1 : 0;
+
+            auto key = std::make_tuple(kind, name, layer);
+            auto it = typeIds.find(key);
+            if (it == typeIds.end()) {
+                LevelType type;
+                if (!copyName(type.animation, name)) {
+                    return tokens.error("animation name is too long");
+                }
+                type.kind = kind;
+                type.layer = layer;
+                it = typeIds.emplace(key, (std::uint32_t)m_textTypes.size()).first;
+                m_textTypes.push_back(type);
+            }
+            tile.type = it->second;
+            m_textTiles.push_back(tile);
+        }
+        else if (head == "Layer") {
+            // following decorations are baked into this layer
+            std::string_view name;
+            LevelLayer layer;
+            if (!tokens.read(name, "a layer name")
+                || !tokens.read(layer.parallax, "a parallax factor")) {
+                return false;
+            }
+            layer.reserved = 0;
+            if (!copyName(layer.name, name)) {
+                return tokens.error("layer name is too long");
+            }
+            m_textLayers.push_back(layer);
+        }
+        else if (head == "Player") {
+            LevelPlayer& player = m_textHeader.player;
+            std::string_view weapon;
+            if (!tokens.read(player.x, "a grid x")
+                || !tokens.read(player.y, "a grid y")
+                || !tokens.read(player.cx, "a bounding box width")
+                || !tokens.read(player.cy, "a bounding box height")
+                || !tokens.read(player.speed, "a speed")
+                || !tokens.read(player.jump, "a jump speed")
+                || !tokens.read(player.maxSpeed, "a max speed")
+                || !tokens.read(player.gravity, "a gravity")
+                || !tokens.read(weapon, "a weapon animation")) {
+                return false;
+            }
+            if (!copyName(player.weapon, weapon)) {
+                return tokens.error("weapon name is too long");
+            }
+            m_textHeader.hasPlayer = 1;
+        }
+        else {
+            return tokens.error(
+                "unknown entry '" + std::string(head) + "', expected Tile, Dec, Layer or Player"
+            );
+        }
+
+        if (profiler) {
+            auto& lineTime = lineTimes[head];
+            lineTime.first += std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - lineStart
+            ).count();
+            lineTime.second++;
+        }
+    }
+
+    if (profiler) {
+        for (auto& [kind, time] : lineTimes) {
+            profiler->add(
+                LoadPhase::LEVEL_PARSE, path + " " + std::string(kind),
+                time.first, 0, time.second
+            );
+        }
+    }
+
+    // stable, so tiles in the same column keep their order in the file
+    std::stable_sort(m_textTiles.begin(), m_textTiles.end(),
+        [](const LevelTile& a, const LevelTile& b) { return a.x < b.x; }
+    );
+
+    m_textHeader.layerCount = (std::uint32_t)m_textLayers.size();
+    m_textHeader.typeCount = (std::uint32_t)m_textTypes.size();
+    m_textHeader.tileCount = (std::uint32_t)m_textTiles.size();
+    m_header = &m_textHeader;
+    m_layers = m_textLayers.data();
+    m_types = m_textTypes.data();
+    m_tiles = m_textTiles.data();
+    return true;
+}
+
+bool LevelFile::mapBinary(const std::string& path) {
+    // the old tables point into the mapping that is about to be replaced,
+    // and the new ones are only kept once everything checked out
+    m_header = nullptr;
+    m_layers = nullptr;
+    m_types = nullptr;
+    m_tiles = nullptr;
+    if (!m_file.open(path)) {
+        std::cerr << "Could not open level " << path << "!\n";
+        return false;
+    }
+
+    const std::uint8_t* data = m_file.data();
+    size_t size = m_file.size();
+    if (size < sizeof(LevelHeader)) {
+        std::cerr << path << " is not a compiled level!\n";
+        return false;
+    }
+    const LevelHeader* header = (const LevelHeader*)data;
+    if (std::memcmp(header->magic, "KLVL", 4) != 0) {
+        std::cerr << path << " is not a compiled level!\n";
+        return false;
+    }
+    if (header->version != LEVEL_VERSION) {
+        std::cerr << path << " has level version " << header->version
+            << ", expected " << LEVEL_VERSION << "!\n";
+        return false;
+    }
+    size_t expected = sizeof(LevelHeader)
+        + (size_t)header->layerCount * sizeof(LevelLayer)
+        + (size_t)header->typeCount * sizeof(LevelType)
+        + (size_t)header->tileCount * sizeof(LevelTile);
+    if (size < expected) {
+        std::cerr << path << " is truncated!\n";
+        return false;
+    }
+    const LevelLayer* layers = (const LevelLayer*)(data + sizeof(LevelHeader));
+    const LevelType* types = (const LevelType*)(layers + header->layerCount);
+    const LevelTile* tiles = (const LevelTile*)(types + header->typeCount);
+
+    // checked once here, so loading can index the tables blindly and
+    // read the names as C strings
+    for (size_t i = 0; i < header->layerCount; i++) {
+        if (!isTerminated(layers[i].name)) {
+            std::cerr << path << " has a broken layer table!\n";
+            return false;
+        }
+    }
+    for (size_t i = 0; i < header->typeCount; i++) {
+        const LevelType& type = types[i];
+        bool knownKind = type.kind == LevelTileKind::TILE
+            || type.kind == LevelTileKind::DECORATION;
+        if (!knownKind || !isTerminated(type.animation)
+            || (type.kind == LevelTileKind::DECORATION && type.layer >= header->layerCount)) {
+            std::cerr << path << " has a broken type table!\n";
+            return false;
+        }
+    }
+    for (size_t i = 0; i < header->tileCount; i++) {
+        if (tiles[i].type >= header->typeCount
+            || (i > 0 && tiles[i].x < tiles[i - 1].x)) {
+            std::cerr << path << " has a broken tile table!\n";
+            return false;
+        }
+    }
+
+    m_header = header;
+    m_layers = layers;
+    m_types = types;
+    m_tiles = tiles;
+    return true;
+}
+
+bool LevelFile::write(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Could not write " << path << "!\n";
+        return false;
+    }
+    file.write((const char*)m_header, sizeof(LevelHeader));
+    file.write((const char*)m_layers, layerCount() * sizeof(LevelLayer));
+    file.write((const char*)m_types, typeCount() * sizeof(LevelType));
+    file.write((const char*)m_tiles, tileCount() * sizeof(LevelTile));
+    return (bool)file;
+}
+
+bool LevelFile::convert(const std::string& textPath, const std::string& binaryPath) {
+    LevelFile level;
+    return level.readText(textPath, nullptr) && level.write(binaryPath);
+}
+
+size_t LevelFile::layerCount() const {
+    return m_header ? m_header->layerCount : 0;
+}
+
+size_t LevelFile::typeCount() const {
+    return m_header ? m_header->typeCount : 0;
+}
+
+size_t LevelFile::tileCount() const {
+    return m_header ? m_header->tileCount : 0;
+}
+
+const LevelLayer& LevelFile::layer(size_t index) const {
+    return m_layers[index];
+}
+
+const LevelType& LevelFile::type(size_t index) const {
+    return m_types[index];
+}
+
+const LevelTile* LevelFile::tiles() const {
+    return m_tiles;
+}
+
+const LevelPlayer* LevelFile::player() const {
+    return m_header && m_header->hasPlayer ? &m_header->player : nullptr;
+}
@@ -0,0 +1,168 @@
+#include "LevelGenerator.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// splitmix64: tiny, fast and fully specified, unlike the standard
+// distributions whose output differs between standard libraries
+class Random
+{
+    std::uint64_t m_state;
+
+    public:
+
+    Random(std::uint64_t seed) : m_state(seed) {}
+
+    std::uint64_t next() {
+        std::uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // uniform in [0, 1)
+    float chance() {
+        return (float)(next() >> 40) / (float)(1ull << 24);
+    }
+
+    // uniform in [low, high]
+    size_t range(size_t low, size_t high) {
+        return low + (size_t)(next() % (high - low + 1));
+    }
+};
+
+struct Decoration
+{
+    const char* animation;
+    size_t x, y;
+};
+
+// columns kept clear around the player start and at the end of the level
+const size_t SAFE_COLUMNS = 8;
+
+}
+
+bool LevelGenerator::write(
+    const std::string& path,
+    const GeneratorConfig& config,
+    Counts& counts
+) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Could not write " << path << "!\n";
+        return false;
+    }
+
+    Random random(config.seed);
+    counts = Counts();
+    auto tile = [&](const char* animation, size_t x, size_t y) {
+        file << "Tile " << animation << " " << x << " " << y << "\n";
+        counts.tiles++;
+    };
+
+    // decorations have to follow the Layer line of their layer, so they
+    // are collected while the tiles are written
+    std::vector<Decoration> clouds;
+    std::vector<Decoration> hills;
+
+    size_t holeLeft = 0; // columns of the current hole still to skip
+    size_t pipeUntil = 0; // first column after the current pipe
+    size_t blocksLeft = 0; // floating blocks of the current row still to place
+    size_t blockRow = 3;
+    size_t hillUntil = 0;
+    size_t cloudUntil = 0;
+
+    for (size_t x = 0; x < config.length; x++) {
+        bool safe = x < SAFE_COLUMNS || x + SAFE_COLUMNS >= config.length;
+
+        // holes are at most two columns wide, so they can always be jumped,
+        // and never sit under a pipe
+        if (holeLeft == 0 && !safe && x >= pipeUntil
+            && random.chance() < config.holeFrequency) {
+            holeLeft = random.range(1, 2);
+        }
+        if (holeLeft > 0) {
+            holeLeft--;
+            blocksLeft = 0;
+            continue;
+        }
+        tile("Ground", x, 0);
+
+        // pipes are two columns wide with one to three body segments
+        if (x >= pipeUntil && !safe && x + 1 < config.length
+            && random.chance() < config.pipeFrequency) {
+            size_t height = random.range(1, 3);
+            for (size_t y = 1; y <= height; y++) {
+                tile("Pipe3", x, y);
+                tile("Pipe4", x + 1, y);
+            }
+            tile("Pipe1", x, height + 1);
+            tile("Pipe2", x + 1, height + 1);
+            // the second column needs ground too, and no hole may follow
+            // straight away
+            tile("Ground", x + 1, 0);
+            pipeUntil = x + 3;
+            blocksLeft = 0;
+            x++;
+            continue;
+        }
+
+        // rows of floating bricks and question blocks, kept off pipes
+        if (blocksLeft == 0 && !safe && random.chance() < config.tileDensity) {
+            blocksLeft = random.range(1, 5);
+            blockRow = random.chance() < 0.7f ? 3 : 7;
+        }
+        if (blocksLeft > 0 && x >= pipeUntil) {
+            blocksLeft--;
+            bool question = random.chance() < config.questionRatio;
+            tile(question ? "Question" : "Brick", x, blockRow);
+        }
+
+        // clouds and hills in the style of level1, on their own layers
+        if (random.chance() < config.decorationDensity) {
+            if (random.chance() < 0.5f) {
+                if (x >= cloudUntil) {
+                    size_t middle = random.range(1, 3);
+                    size_t y = random.range(7, 9);
+                    clouds.push_back({ "Cloud1", x, y + 1 });
+                    clouds.push_back({ "Cloud4", x, y });
+                    for (size_t i = 1; i <= middle; i++) {
+                        clouds.push_back({ "Cloud2", x + i, y + 1 });
+                        clouds.push_back({ "Cloud5", x + i, y });
+                    }
+                    clouds.push_back({ "Cloud3", x + middle + 1, y + 1 });
+                    clouds.push_back({ "Cloud6", x + middle + 1, y });
+                    cloudUntil = x + middle + 3;
+                }
+            }
+            else if (x >= hillUntil) {
+                hills.push_back({ "Mountain2", x, 1 });
+                hills.push_back({ "Mountain3", x + 1, 1 });
+                hills.push_back({ "Mountain4", x + 2, 1 });
+                hills.push_back({ "Mountain5", x + 3, 1 });
+                hills.push_back({ "Mountain6", x + 4, 1 });
+                hills.push_back({ "Mountain2", x + 1, 2 });
+                hills.push_back({ "Mountain3", x + 2, 2 });
+                hills.push_back({ "Mountain6", x + 3, 2 });
+                hills.push_back({ "Mountain1", x + 2, 3 });
+                hillUntil = x + 6;
+            }
+        }
+    }
+
+    file << "Layer Clouds 0.5\n";
+    for (auto& d : clouds) {
+        file << "Dec " << d.animation << " " << d.x << " " << d.y << "\n";
+    }
+    file << "Layer Hills 0.75\n";
+    for (auto& d : hills) {
+        file << "Dec " << d.animation << " " << d.x << " " << d.y << "\n";
+    }
+    counts.decorations = clouds.size() + hills.size();
+
+    file << "Player 2 6 48 48 5 -20 20 0.75 Buster\n";
+    return (bool)file;
+}
@@ -0,0 +1,178 @@
+#include "LevelStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+LevelStreamer::LevelStreamer() {}
+
+LevelStreamer::~LevelStreamer() {
+    close();
+}
+
+bool LevelStreamer::open(const std::string& path, LoadProfiler* profiler) {
+    close();
+    m_level = std::make_unique<LevelFile>();
+    if (!m_level->open(path, profiler)) {
+        return false;
+    }
+
+    size_t tileCount = m_level->tileCount();
+    size_t chunkCount = tileCount == 0 ? 0 : chunkOf(m_level->tiles()[tileCount - 1].x) + 1;
+    m_chunks = std::vector<Chunk>(chunkCount);
+    m_changes.clear();
+
+    m_running = true;
+    m_thread = std::thread(&LevelStreamer::run, this);
+    return true;
+}
+
+void LevelStreamer::close() {
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+    }
+    m_queue.clear();
+    m_resident.clear();
+    m_chunks.clear();
+}
+
+const LevelFile& LevelStreamer::level() const {
+    return *m_level;
+}
+
+size_t LevelStreamer::chunkCount() const {
+    return m_chunks.size();
+}
+
+size_t LevelStreamer::chunkOf(float gridX) const {
+    return gridX <= 0 ? 0 : (size_t)std::floor(gridX / CHUNK_WIDTH);
+}
+
+void LevelStreamer::load(size_t chunk, std::vector<ChunkTile>& tiles) const {
+    // tiles are sorted by x, so the chunk is one contiguous range and only
+    // its pages of a mapped level are read
+    const LevelTile* begin = m_level->tiles();
+    const LevelTile* end = begin + m_level->tileCount();
+    auto byX = [](const LevelTile& tile, float x) { return tile.x < x; };
+    const LevelTile* first = chunk == 0
+        ? begin : std::lower_bound(begin, end, (float)(chunk * CHUNK_WIDTH), byX);
+    const LevelTile* last = chunk + 1 == m_chunks.size()
+        ? end : std::lower_bound(first, end, (float)((chunk + 1) * CHUNK_WIDTH), byX);
+
+    tiles.clear();
+    for (const LevelTile* tile = first; tile != last; tile++) {
+        if (m_level->type(tile->type).kind != LevelTileKind::TILE) {
+            continue;
+        }
+        ChunkTile chunkTile;
+        chunkTile.record = (std::uint32_t)(tile - begin);
+        chunkTile.type = tile->type;
+        chunkTile.x = tile->x;
+        chunkTile.y = tile->y;
+        tiles.push_back(chunkTile);
+    }
+}
+
+void LevelStreamer::run() {
+    std::vector<ChunkTile> tiles;
+    while (true) {
+        size_t chunk;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return !m_queue.empty() || !m_running; });
+            if (!m_running) {
+                break;
+            }
+            chunk = m_queue.front();
+            m_queue.pop_front();
+            m_chunks[chunk].state = ChunkState::LOADING;
+        }
+
+        load(chunk, tiles);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // the chunk may have been unloaded again while it was loading
+            if (m_chunks[chunk].state == ChunkState::LOADING) {
+                m_chunks[chunk].tiles.swap(tiles);
+                m_chunks[chunk].state = ChunkState::LOADED;
+            }
+        }
+        m_cv.notify_all();
+    }
+}
+
+void LevelStreamer::prefetch(size_t first, size_t last) {
+    auto inWindow = [first, last](size_t i) { return first <= i && i <= last; };
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // chunks that left the window, still queued ones are just dropped
+        m_queue.erase(
+            std::remove_if(m_queue.begin(), m_queue.end(),
+                [&inWindow](size_t i) { return !inWindow(i); }),
+            m_queue.end()
+        );
+        for (size_t i = 0; i < m_resident.size();) {
+            Chunk& chunk = m_chunks[m_resident[i]];
+            if (inWindow(m_resident[i])) {
+                i++;
+                continue;
+            }
+            chunk.state = ChunkState::UNLOADED;
+            std::vector<ChunkTile>().swap(chunk.tiles);
+            m_resident[i] = m_resident.back();
+            m_resident.pop_back();
+        }
+
+        // chunks that entered it, queued after the ones already waiting
+        for (size_t i = first; i <= last && i < m_chunks.size(); i++) {
+            if (m_chunks[i].state == ChunkState::UNLOADED) {
+                m_chunks[i].state = ChunkState::QUEUED;
+                m_queue.push_back(i);
+                m_resident.push_back(i);
+                queued = true;
+            }
+        }
+    }
+    if (queued) {
+        m_cv.notify_all();
+    }
+}
+
+const std::vector<ChunkTile>& LevelStreamer::tiles(size_t chunk) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Chunk& c = m_chunks[chunk];
+    if (c.state == ChunkState::UNLOADED || c.state == ChunkState::QUEUED) {
+        // needed right now, so it goes to the front of the queue
+        auto queued = std::find(m_queue.begin(), m_queue.end(), chunk);
+        if (queued != m_queue.end()) {
+            m_queue.erase(queued);
+        }
+        if (c.state == ChunkState::UNLOADED) {
+            m_resident.push_back(chunk);
+        }
+        c.state = ChunkState::QUEUED;
+        m_queue.push_front(chunk);
+        m_cv.notify_all();
+    }
+    m_cv.wait(lock, [&c] { return c.state == ChunkState::LOADED; });
+    return c.tiles;
+}
+
+void LevelStreamer::setChange(std::uint32_t record, TileChange change) {
+    m_changes[record] = change;
+}
+
+TileChange LevelStreamer::change(std::uint32_t record) const {
+    auto it = m_changes.find(record);
+    return it == m_changes.end() ? TileChange::NONE : it->second;
+}
+
+void LevelStreamer::clearChanges() {
+    m_changes.clear();
+}
@@ -0,0 +1,144 @@
+#include "LoadProfiler.h"
+#include "Json.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+static const LoadPhase PHASES[] = {
+    LoadPhase::CONFIG, LoadPhase::FONT, LoadPhase::DECODE, LoadPhase::METADATA,
+    LoadPhase::UPLOAD, LoadPhase::WINDOW, LoadPhase::LEVEL_PARSE,
+    LoadPhase::LEVEL_BUILD
+};
+
+const char* LoadProfiler::phaseName(LoadPhase phase) {
+    switch (phase) {
+        case LoadPhase::CONFIG: return "config";
+        case LoadPhase::FONT: return "font";
+        case LoadPhase::DECODE: return "decode";
+        case LoadPhase::METADATA: return "metadata";
+        case LoadPhase::UPLOAD: return "upload";
+        case LoadPhase::WINDOW: return "window";
+        case LoadPhase::LEVEL_PARSE: return "level parse";
+        case LoadPhase::LEVEL_BUILD: return "level build";
+    }
+    return "unknown";
+}
+
+void LoadProfiler::add(
+    LoadPhase phase,
+    const std::string& name,
+    double seconds,
+    size_t bytes,
+    size_t count
+) {
+    LoadEvent event;
+    event.phase = phase;
+    event.name = name;
+    event.seconds = seconds;
+    event.bytes = bytes;
+    event.count = count;
+
+    // events are added once they finish, so the span ends now
+    TraceRecorder& trace = TraceRecorder::instance();
+    if (trace.isRecording()) {
+        auto end = std::chrono::steady_clock::now();
+        auto start = end - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(seconds)
+        );
+        std::string spanName = std::string(phaseName(phase)) + " " + name;
+        trace.span("load", spanName.c_str(), start, end);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_events.push_back(event);
+}
+
+void LoadProfiler::noteDecodeThreads(size_t threads) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_decodeThreads = std::max(m_decodeThreads, threads);
+}
+
+void LoadProfiler::setInitSeconds(double seconds) {
+    m_initSeconds = seconds;
+}
+
+const std::vector<LoadEvent>& LoadProfiler::events() const {
+    return m_events;
+}
+
+void LoadProfiler::printSummary(std::ostream& out) const {
+    out << std::fixed << std::setprecision(2);
+    out << "startup:          " << m_initSeconds * 1000.0 << " ms\n";
+    for (LoadPhase phase : PHASES) {
+        double seconds = 0;
+        size_t bytes = 0;
+        size_t count = 0;
+        for (auto& event : m_events) {
+            if (event.phase == phase) {
+                seconds += event.seconds;
+                bytes += event.bytes;
+                count += event.count;
+            }
+        }
+        if (count == 0) {
+            continue;
+        }
+        std::string label = std::string(phaseName(phase)) + ":";
+        out << std::left << std::setw(18) << label << std::right
+            << seconds * 1000.0 << " ms, " << count << " items, "
+            << bytes / 1024.0 << " KB\n";
+    }
+    // decode runs on several threads, so its total can exceed startup
+    if (m_decodeThreads > 1) {
+        out << "(decode is summed over " << m_decodeThreads << " worker threads)\n";
+    }
+
+    std::vector<const LoadEvent*> slowest;
+    for (auto& event : m_events) {
+        slowest.push_back(&event);
+    }
+    std::sort(slowest.begin(), slowest.end(), [](const LoadEvent* a, const LoadEvent* b) {
+        return a->seconds > b->seconds;
+    });
+    out << "slowest:\n";
+    for (size_t i = 0; i < slowest.size() && i < 5; i++) {
+        out << "  " << std::setw(8) << slowest[i]->seconds * 1000.0 << " ms  "
+            << phaseName(slowest[i]->phase) << " " << slowest[i]->name << "\n";
+    }
+    out << std::defaultfloat;
+}
+
+bool LoadProfiler::writeJson(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Could not write load profile " << path << "!\n";
+        return false;
+    }
+    file << "{\n  \"startup_ms\": " << m_initSeconds * 1000.0 << ",\n";
+    file << "  \"events\": [";
+    for (size_t i = 0; i < m_events.size(); i++) {
+        const LoadEvent& event = m_events[i];
+        file << (i == 0 ? "\n" : ",\n")
+            << "    {\"phase\": " << jsonString(phaseName(event.phase))
+            << ", \"name\": " << jsonString(event.name)
+            << ", \"ms\": " << event.seconds * 1000.0
+            << ", \"bytes\": " << event.bytes
+            << ", \"count\": " << event.count << "}";
+    }
+    file << "\n  ]\n}\n";
+    return true;
+}
+
+LoadTimer::LoadTimer()
+    : m_start(std::chrono::steady_clock::now())
+{
+}
+
+double LoadTimer::seconds() const {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - m_start
+    ).count();
+}
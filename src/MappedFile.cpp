@@ -0,0 +1,126 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    m_file = CreateFileA(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+    if (m_file == INVALID_HANDLE_VALUE) {
+        m_file = nullptr;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size)) {
+        close();
+        return false;
+    }
+    m_size = (size_t)size.QuadPart;
+    if (m_size == 0) {
+        // empty files cannot be mapped, but are valid
+        return true;
+    }
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping) {
+        close();
+        return false;
+    }
+    m_data = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!m_data) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+    }
+    if (m_file) {
+        CloseHandle(m_file);
+    }
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    m_size = 0;
+}
+
+bool MappedFile::isOpen() const {
+    return m_file != nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    m_fd = ::open(path.c_str(), O_RDONLY);
+    if (m_fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(m_fd, &info) != 0) {
+        close();
+        return false;
+    }
+    m_size = (size_t)info.st_size;
+    if (m_size == 0) {
+        // empty files cannot be mapped, but are valid
+        return true;
+    }
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (data == MAP_FAILED) {
+        close();
+        return false;
+    }
+    m_data = (const unsigned char*)data;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        munmap((void*)m_data, m_size);
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_data = nullptr;
+    m_fd = -1;
+    m_size = 0;
+}
+
+bool MappedFile::isOpen() const {
+    return m_fd >= 0;
+}
+
+#endif
+
+const unsigned char* MappedFile::data() const {
+    return m_data;
+}
+
+size_t MappedFile::size() const {
+    return m_size;
+}
@@ -1,8 +1,56 @@
 #include "Physics.h"
 #include "Entity.h"
+#include <algorithm>
 #include <cstdlib>
+#include <map>
 #include <memory>
 
+std::vector<GridRect> Physics::MergeCells(std::vector<std::pair<int, int>> cells) {
+    // row by row, left to right
+    std::sort(cells.begin(), cells.end(), [](auto& a, auto& b) {
+        return a.second != b.second ? a.second < b.second : a.first < b.first;
+    });
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+    std::vector<GridRect> rects;
+    // rects that reach the previous row, by their [x, x + width) span
+    std::map<std::pair<int, int>, size_t> open, next;
+    for (size_t i = 0; i < cells.size();) {
+        int y = cells[i].second;
+
+        // maximal run of consecutive cells in this row
+        int x = cells[i].first;
+        size_t j = i + 1;
+        while (j < cells.size() && cells[j].second == y && cells[j].first == cells[j - 1].first + 1) {
+            j++;
+        }
+        int width = (int)(j - i);
+
+        auto span = std::make_pair(x, width);
+        auto below = open.find(span);
+        if (below != open.end()) {
+            rects[below->second].height++;
+            next[span] = below->second;
+        }
+        else {
+            rects.push_back({ x, y, width, 1 });
+            next[span] = rects.size() - 1;
+        }
+        i = j;
+
+        // end of the row, only rects continued in it stay open, and
+        // only if the next row is right above
+        if (i == cells.size() || cells[i].second != y) {
+            open.swap(next);
+            next.clear();
+            if (i < cells.size() && cells[i].second != y + 1) {
+                open.clear();
+            }
+        }
+    }
+    return rects;
+}
+
 Vec2 Physics::GetOverlap(std::shared_ptr<Entity> a, std::shared_ptr<Entity> b) {
     // todo: return the overlap rectangle size of the bouding boxes of enetity a and b
     Vec2 posA = a->getComponent<CTransform>().pos;
@@ -0,0 +1,58 @@
+#include "RenderFrame.h"
+
+void RenderFrame::clear() {
+    layers.clear();
+    layerOffsets.clear();
+    queue.clear();
+    lines.clear();
+    texts.clear();
+}
+
+void RenderFrame::addLayer(
+    std::shared_ptr<const BackgroundLayer> layer,
+    const sf::Vector2f& offset
+) {
+    layers.push_back(layer);
+    layerOffsets.push_back(offset);
+}
+
+void RenderFrame::addLine(
+    const sf::Vector2f& p1,
+    const sf::Vector2f& p2,
+    const sf::Color& color
+) {
+    lines.push_back(sf::Vertex(p1, color));
+    lines.push_back(sf::Vertex(p2, color));
+}
+
+void RenderFrame::draw(sf::RenderTarget& target, RenderStats& stats) {
+    target.setView(view);
+    target.clear(clearColor);
+    for (size_t i = 0; i < layers.size(); i++) {
+        layers[i]->draw(target, layerOffsets[i]);
+    }
+    queue.flush(target);
+    if (!lines.empty()) {
+        target.draw(lines.data(), lines.size(), sf::Lines);
+    }
+    for (auto& text : texts) {
+        target.draw(text);
+    }
+    addStats(stats);
+}
+
+void RenderFrame::record(RenderStats& stats) {
+    queue.record();
+    addStats(stats);
+}
+
+void RenderFrame::addStats(RenderStats& stats) const {
+    stats.frames++;
+    stats.commands += queue.lastCommandCount();
+    stats.batches += queue.lastBatchCount();
+    for (auto& layer : layers) {
+        stats.batches += layer->meshCount();
+    }
+    stats.lines += lines.size() / 2;
+    stats.texts += texts.size();
+}
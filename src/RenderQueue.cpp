@@ -0,0 +1,175 @@
+#include "RenderQueue.h"
+
+#include <cmath>
+
+std::uint64_t RenderQueue::makeKey(
+    RenderLayer layer,
+    std::uint32_t texture,
+    std::uint32_t depth
+) {
+    return ((std::uint64_t)layer << 56)
+        | ((std::uint64_t)(texture & 0xFFFFFF) << 32)
+        | (std::uint64_t)depth;
+}
+
+void RenderQueue::makeTransform(
+    float out[6],
+    const sf::IntRect& rect,
+    const Vec2& pos,
+    const Vec2& scale,
+    float angle
+) {
+    // same matrix sf::Transformable builds, with the origin at the rect center
+    float radians = -angle * 3.141592654f / 180.0f;
+    float cosine = std::cos(radians);
+    float sine = std::sin(radians);
+    float sxc = scale.x * cosine;
+    float syc = scale.y * cosine;
+    float sxs = scale.x * sine;
+    float sys = scale.y * sine;
+    float ox = rect.width / 2.0f;
+    float oy = rect.height / 2.0f;
+    out[0] = sxc;
+    out[1] = sys;
+    out[2] = -ox * sxc - oy * sys + pos.x;
+    out[3] = -sxs;
+    out[4] = syc;
+    out[5] = ox * sxs - oy * syc + pos.y;
+}
+
+void RenderQueue::appendQuad(
+    std::vector<sf::Vertex>& vertices,
+    const sf::IntRect& rect,
+    const float transform[6]
+) {
+    const float* m = transform;
+    float w = (float)rect.width;
+    float h = (float)rect.height;
+    float u = (float)rect.left;
+    float v = (float)rect.top;
+    auto corner = [&](float x, float y) {
+        return sf::Vertex(
+            sf::Vector2f(m[0] * x + m[1] * y + m[2], m[3] * x + m[4] * y + m[5]),
+            sf::Vector2f(u + x, v + y)
+        );
+    };
+    sf::Vertex topLeft = corner(0, 0);
+    sf::Vertex topRight = corner(w, 0);
+    sf::Vertex bottomLeft = corner(0, h);
+    sf::Vertex bottomRight = corner(w, h);
+    vertices.push_back(topLeft);
+    vertices.push_back(topRight);
+    vertices.push_back(bottomLeft);
+    vertices.push_back(bottomLeft);
+    vertices.push_back(topRight);
+    vertices.push_back(bottomRight);
+}
+
+void RenderQueue::submit(
+    RenderLayer layer,
+    std::uint32_t depth,
+    std::uint32_t textureId,
+    const sf::Texture* texture,
+    const sf::IntRect& rect,
+    const Vec2& pos,
+    const Vec2& scale,
+    float angle
+) {
+    RenderCommand cmd;
+    cmd.key = makeKey(layer, textureId, depth);
+    cmd.texture = texture;
+    cmd.textureRect = rect;
+    makeTransform(cmd.transform, rect, pos, scale, angle);
+    m_commands.push_back(cmd);
+}
+
+void RenderQueue::sort() {
+    // LSD radix sort on the 64 bit key, one byte per pass
+    // passes where every key has the same byte are skipped, which is the
+    // common case for the layer and texture bytes
+    const size_t n = m_commands.size();
+    m_scratch.resize(n);
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = { 0 };
+        for (auto& cmd : m_commands) {
+            counts[(cmd.key >> shift) & 0xFF]++;
+        }
+        if (counts[(m_commands[0].key >> shift) & 0xFF] == n) {
+            continue;
+        }
+        size_t offset = 0;
+        for (auto& count : counts) {
+            size_t c = count;
+            count = offset;
+            offset += c;
+        }
+        for (auto& cmd : m_commands) {
+            m_scratch[counts[(cmd.key >> shift) & 0xFF]++] = cmd;
+        }
+        m_commands.swap(m_scratch);
+    }
+}
+
+void RenderQueue::drawBatch(sf::RenderTarget* target, const sf::Texture* texture) {
+    if (m_vertices.empty()) {
+        return;
+    }
+    if (target) {
+        sf::RenderStates states;
+        states.texture = texture;
+        target->draw(m_vertices.data(), m_vertices.size(), sf::Triangles, states);
+    }
+    m_vertices.clear();
+    m_lastBatchCount++;
+}
+
+void RenderQueue::flush(sf::RenderTarget& target) {
+    flush(&target);
+}
+
+void RenderQueue::record() {
+    flush(nullptr);
+}
+
+void RenderQueue::flush(sf::RenderTarget* target) {
+    m_lastBatchCount = 0;
+    m_lastCommandCount = m_commands.size();
+    if (m_commands.empty()) {
+        return;
+    }
+    sort();
+
+    // consecutive commands with the same texture become one draw call,
+    // compared by the id in the key so recording without textures
+    // batches the same way
+    auto textureOf = [](const RenderCommand& cmd) { return (cmd.key >> 32) & 0xFFFFFF; };
+    const sf::Texture* batchTexture = m_commands[0].texture;
+    std::uint64_t batchId = textureOf(m_commands[0]);
+    for (auto& cmd : m_commands) {
+        if (textureOf(cmd) != batchId) {
+            drawBatch(target, batchTexture);
+            batchTexture = cmd.texture;
+            batchId = textureOf(cmd);
+        }
+
+        appendQuad(m_vertices, cmd.textureRect, cmd.transform);
+    }
+    drawBatch(target, batchTexture);
+    m_commands.clear();
+}
+
+void RenderQueue::clear() {
+    m_commands.clear();
+}
+
+size_t RenderQueue::size() const {
+    return m_commands.size();
+}
+
+size_t RenderQueue::lastBatchCount() const {
+    return m_lastBatchCount;
+}
+
+size_t RenderQueue::lastCommandCount() const {
+    return m_lastCommandCount;
+}
@@ -0,0 +1,91 @@
+#include "RenderThread.h"
+#include "FrameProfiler.h"
+#include "TraceRecorder.h"
+
+#include <utility>
+
+RenderThread::RenderThread(sf::RenderWindow& window, FrameDrawFunc drawFunc)
+    : m_window(window)
+    , m_drawFunc(drawFunc) {}
+
+RenderThread::~RenderThread() {
+    stop();
+}
+
+void RenderThread::start() {
+    if (m_running) {
+        return;
+    }
+    // the GL context can only be active in one thread at a time
+    m_window.setActive(false);
+    m_running = true;
+    m_thread = std::thread(&RenderThread::run, this);
+}
+
+void RenderThread::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+    m_window.setActive(true);
+}
+
+bool RenderThread::isRunning() const {
+    return m_running;
+}
+
+RenderFrame& RenderThread::backFrame() {
+    return m_frames[m_back];
+}
+
+void RenderThread::publish() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(m_back, m_ready);
+        m_hasNewFrame = true;
+    }
+    m_cv.notify_all();
+}
+
+void RenderThread::sync() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this] {
+        return !m_running || (!m_hasNewFrame && !m_drawing);
+    });
+}
+
+void RenderThread::run() {
+    TraceRecorder::instance().setThreadName("render");
+    m_window.setActive(true);
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_hasNewFrame || !m_running; });
+            if (!m_running) {
+                break;
+            }
+            std::swap(m_front, m_ready);
+            m_hasNewFrame = false;
+            m_drawing = true;
+        }
+
+        // vsync and the frame limiter block here, not in the simulation
+        m_drawFunc(m_frames[m_front]);
+        {
+            PROFILE_SCOPE(DISPLAY);
+            m_window.display();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_drawing = false;
+        }
+        m_cv.notify_all();
+    }
+    m_window.setActive(false);
+}
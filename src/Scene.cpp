@@ -1,4 +1,5 @@
 #include "Scene.h"
+#include "InputScript.h"
 #include "SFML/Graphics/PrimitiveType.hpp"
 
 Scene::Scene() {}
@@ -12,18 +13,35 @@ void Scene::doAction(const Action& action) {
     sDoAction(action);
 }
 
-void Scene::simulate(const size_t frames) {}
+void Scene::onFileChanged(const std::string&) {}
+
+bool Scene::isLoading() const {
+    return false;
+}
+
+void Scene::step() {}
+
+size_t Scene::simulate(const size_t frames, InputScript* inputs) {
+    size_t tick = 0;
+    for (; tick < frames && !m_hasEnded; tick++) {
+        if (inputs) {
+            inputs->apply(*this, tick);
+        }
+        step();
+    }
+    return tick;
+}
 
 void Scene::registerAction(int inputKey, const std::string& actionName) {
     m_actionMap[inputKey] = actionName;
 }
 
 size_t Scene::width() const {
-    return m_game->window().getSize().x;
+    return m_game->size().x;
 }
 
 size_t Scene::height() const {
-    return m_game->window().getSize().y;
+    return m_game->size().y;
 }
 
 size_t Scene::currentFrame() const {
@@ -38,11 +56,14 @@ ActionMap& Scene::getActionMap() {
     return m_actionMap;
 }
 
-void Scene::drawLine(const Vec2& p1, const Vec2& p2) {
-    sf::Vertex line[] = {
-        sf::Vertex(sf::Vector2f(p1.x, p1.y)),
-        sf::Vertex(sf::Vector2f(p2.x, p2.y))
-    };
+EntityManager& Scene::getEntityManager() {
+    return m_entityManager;
+}
 
-    m_game->window().draw(line, 2, sf::Lines);
+void Scene::drawLine(const Vec2& p1, const Vec2& p2) {
+    m_game->frame().addLine(
+        sf::Vector2f(p1.x, p1.y),
+        sf::Vector2f(p2.x, p2.y),
+        sf::Color::White
+    );
 }
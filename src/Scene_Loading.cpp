@@ -0,0 +1,104 @@
+#include "Scene_Loading.h"
+#include "Scene_Menu.h"
+#include "TraceRecorder.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+Scene_Loading::Scene_Loading(GameEngine* gameEngine, const std::string& levelPath)
+    : Scene(gameEngine)
+    , m_levelPath(levelPath)
+{
+    init();
+}
+
+Scene_Loading::~Scene_Loading() {
+    // the level cannot be abandoned half built, quitting waits for it
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+}
+
+void Scene_Loading::init() {
+    std::string title = "LOADING "
+        + std::filesystem::path(m_levelPath).stem().string();
+    int titleSize = 26;
+    m_titleText.setString(title);
+    m_titleText.setFont(m_game->assets().getFont("Mario"));
+    m_titleText.setCharacterSize(titleSize);
+    m_titleText.setFillColor(sf::Color::Black);
+    m_titleText.setPosition(
+        m_game->size().x / 2.0
+        - titleSize * (title.length() + 1) / 2.0,
+        m_game->size().y / 2.0 - titleSize * 3
+    );
+
+    m_worker = std::thread(&Scene_Loading::load, this);
+}
+
+void Scene_Loading::load() {
+    TraceRecorder::instance().setThreadName("level loader");
+    m_scene = std::make_shared<Scene_Play>(m_game, m_levelPath, &m_progress);
+    m_done = true;
+}
+
+void Scene_Loading::update() {
+    if (m_done) {
+        m_worker.join();
+        // the engine keeps this scene under its own name, so it is
+        // still alive for the rest of this frame
+        if (m_scene->isLoaded()) {
+            m_scene->finishLoading();
+            m_game->changeScene("PLAY", m_scene);
+        }
+        else {
+            // the level's own error was printed by the worker
+            std::cerr << "Could not load " << m_levelPath << ", back to the menu\n";
+            m_game->changeScene("MENU", std::make_shared<Scene_Menu>(m_game));
+        }
+        m_scene = nullptr;
+    }
+    sRender();
+}
+
+void Scene_Loading::onEnd() {}
+
+void Scene_Loading::sDoAction(const Action&) {}
+
+bool Scene_Loading::isLoading() const {
+    return !m_done;
+}
+
+void Scene_Loading::sRender() {
+    RenderFrame& frame = m_game->frame();
+    frame.clearColor = sf::Color(100, 100, 255);
+    frame.texts.push_back(m_titleText);
+
+    // outlined bar, filled with one line per pixel row
+    float width = m_game->size().x / 2.0f;
+    float height = 24;
+    float left = (m_game->size().x - width) / 2.0f;
+    float top = m_game->size().y / 2.0f;
+    float progress = m_progress;
+    sf::Color color = sf::Color::Black;
+    frame.addLine({ left, top }, { left + width, top }, color);
+    frame.addLine({ left + width, top }, { left + width, top + height }, color);
+    frame.addLine({ left + width, top + height }, { left, top + height }, color);
+    frame.addLine({ left, top + height }, { left, top }, color);
+    for (float y = top + 2; y < top + height - 1; y++) {
+        frame.addLine(
+            { left + 2, y }, { left + 2 + (width - 4) * progress, y },
+            sf::Color::White
+        );
+    }
+
+    char percent[8];
+    std::snprintf(percent, sizeof(percent), "%d%%", (int)(progress * 100));
+    sf::Text text(percent, m_game->assets().getFont("Mario"), 20);
+    text.setFillColor(sf::Color::Black);
+    text.setPosition(
+        m_game->size().x / 2.0 - 20 * 2, top + height + 10
+    );
+    frame.texts.push_back(text);
+}
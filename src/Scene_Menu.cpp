@@ -1,5 +1,5 @@
 #include "Scene_Menu.h"
-#include "Scene_Play.h"
+#include "Scene_Loading.h"
 #include "SFML/Graphics/Text.hpp"
 
 void Scene_Menu::init() {
@@ -15,10 +15,13 @@ void Scene_Menu::init() {
     m_menuText.setCharacterSize(titleSize);
     m_menuText.setFillColor(sf::Color::Black);
     m_menuText.setPosition(
-        m_game->window().getSize().x / 2.0 
+        m_game->size().x / 2.0 
         - titleSize * (m_title.length() + 1) / 2.0,
         titleSize * 3
     );
+    // items are laid out from the title position rather than its bounds,
+    // measuring text loads glyphs, which only the drawing thread may do
+    m_menuTop = m_menuText.getPosition().y;
     m_menuStrings.push_back("LEVEL 1");
     m_menuStrings.push_back("LEVEL 2");
     m_menuStrings.push_back("LEVEL 3");
@@ -35,9 +38,9 @@ void Scene_Menu::init() {
             text.setFillColor(sf::Color::Black);
         }
         text.setPosition(
-            m_game->window().getSize().x / 2.0
+            m_game->size().x / 2.0
             - 26 * (m_menuStrings[i].length() + 1) / 2.0,
-            m_menuText.getGlobalBounds().top + 10 + 30 * (i + 1)
+            m_menuTop + 10 + 30 * (i + 1)
         );
         m_menuItems.push_back(text);
     }
@@ -66,8 +69,9 @@ void Scene_Menu::sDoAction(const Action& action) {
                 % m_menuStrings.size();
         }
         else if (action.name() == "PLAY") {
-            m_game->changeScene("PLAY",
-                std::make_shared<Scene_Play>(
+            // the level is built on a worker, the menu does not freeze
+            m_game->changeScene("LOADING",
+                std::make_shared<Scene_Loading>(
                     m_game, m_levelPaths[m_selectedMenuIndex]
                 )
             );
@@ -83,11 +87,13 @@ Scene_Menu::Scene_Menu(GameEngine* gameEngine) : Scene(gameEngine) {
 }
 
 void Scene_Menu::sRender() {
+    RenderFrame& frame = m_game->frame();
+
     // set menu background
-    m_game->window().clear(sf::Color(100, 100, 255));
+    frame.clearColor = sf::Color(100, 100, 255);
     
     // draw title
-    m_game->window().draw(m_menuText);
+    frame.texts.push_back(m_menuText);
 
     // draw menu items
     for (int i=0; i<m_menuStrings.size(); i++) {
@@ -99,11 +105,11 @@ void Scene_Menu::sRender() {
         }
 
         m_menuItems[i].setPosition(
-            m_game->window().getSize().x / 2.0
+            m_game->size().x / 2.0
             - 26 * (m_menuStrings[i].length() + 1) / 2.0,
-            m_menuText.getGlobalBounds().top + 10 + 30 * (i + 1)
+            m_menuTop + 10 + 30 * (i + 1)
         );
-        m_game->window().draw(m_menuItems[i]);
+        frame.texts.push_back(m_menuItems[i]);
     }
 
     // draw help
@@ -113,9 +119,9 @@ void Scene_Menu::sRender() {
     );
     help.setFillColor(sf::Color::Black);
     help.setPosition(
-        m_game->window().getSize().x / 2.0
+        m_game->size().x / 2.0
         - 26 * (help.getString().getSize() + 1) / 2.0,
-        m_game->window().getSize().y - 30 * 2
+        m_game->size().y - 30 * 2
     );
-    m_game->window().draw(help);
+    frame.texts.push_back(help);
 }
@@ -4,26 +4,41 @@
 #include "GameEngine.h"
 #include "Components.h"
 #include "Action.h"
+#include "FrameProfiler.h"
 
 #include "SFML/System/Vector2.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
 #include <string>
+#include <unordered_map>
 #include <fstream>
 
-Scene_Play::Scene_Play(GameEngine* gameEngine, std::string& levelPath)
+Scene_Play::Scene_Play(
+    GameEngine* gameEngine,
+    const std::string& levelPath,
+    std::atomic<float>* progress
+)
     : Scene(gameEngine)
     , m_levelPath(levelPath)
+    , m_loadProgress(progress)
 {
     init(m_levelPath);
+    // the loading scene is gone once this scene takes over
+    m_loadProgress = nullptr;
 }
 
 void Scene_Play::init(const std::string& levelPath) {
     registerAction(sf::Keyboard::P, "PAUSE");
+    registerAction(sf::Keyboard::R, "RESTART");
     registerAction(sf::Keyboard::Escape, "QUIT");
     registerAction(sf::Keyboard::T, "TOGGLE_TEXTURE"); // toggle drawing Textures
     registerAction(sf::Keyboard::C, "TOGGLE_COLLISION"); // toggle drawing Collision Boxes
     registerAction(sf::Keyboard::G, "TOGGLE_GRID"); // toggle drawing Grid
+    registerAction(sf::Keyboard::F, "TOGGLE_PROFILER"); // toggle the frame profiler overlay
 
     // todo: register all other gameplay Actions
     // keymaps for playing
@@ -38,7 +53,34 @@ void Scene_Play::init(const std::string& levelPath) {
     m_scoreText.setCharacterSize(20);
     m_scoreText.setFont(m_game->assets().getFont("Mario"));
     m_scoreText.setString("Score: 0");
-    loadLevel(levelPath);
+    m_profilerText.setCharacterSize(12);
+    m_profilerText.setFont(m_game->assets().getFont("Mario"));
+    resolveAnimationIds();
+    m_loaded = loadLevel(levelPath);
+    if (m_loaded) {
+        m_game->watchFile(levelPath);
+    }
+}
+
+bool Scene_Play::isLoaded() const {
+    return m_loaded;
+}
+
+void Scene_Play::resolveAnimationIds() {
+    const Assets& assets = m_game->assets();
+    m_anim.stand = assets.getAnimationId("Stand");
+    m_anim.air = assets.getAnimationId("Air");
+    m_anim.run = assets.getAnimationId("Run");
+    m_anim.standShoot = assets.getAnimationId("StandShoot");
+    m_anim.airShoot = assets.getAnimationId("AirShoot");
+    m_anim.runShoot = assets.getAnimationId("RunShoot");
+    m_anim.brick = assets.getAnimationId("Brick");
+    m_anim.brickDebris = assets.getAnimationId("BrickDebris");
+    m_anim.question = assets.getAnimationId("Question");
+    m_anim.questionHit = assets.getAnimationId("QuestionHit");
+    m_anim.coinSpin = assets.getAnimationId("CoinSpin");
+    // the weapon comes from the level's Player line
+    m_anim.weapon = NO_ASSET;
 }
 
 Vec2 Scene_Play::gridToMidPixel(
@@ -48,8 +90,13 @@ Vec2 Scene_Play::gridToMidPixel(
 ) {
     //this function takes in a grid position and an Entity
     //returns a Vec2 indicating where the center position of the Entity should be 
+    return gridToMidPixel(
+        gridX, gridY, entity->getComponent<CAnimation>().animation.getSize()
+    );
+}
+
+Vec2 Scene_Play::gridToMidPixel(float gridX, float gridY, const Vec2& eSize) {
     float offsetX, offsetY;
-    auto eSize = entity->getComponent<CAnimation>().animation.getSize();
     float eScale;
     switch ((int)eSize.y) {
         case 16:
@@ -69,72 +116,454 @@ Vec2 Scene_Play::gridToMidPixel(
     );
 }
 
-void Scene_Play::loadLevel(const std::string& fileName) {
+bool Scene_Play::loadLevel(const std::string& fileName) {
     // reset the EntityManager every time we load a level
     m_entityManager = EntityManager();
+    m_backgroundLayers.clear();
+    m_activeChunks.clear();
+    m_prefetchFirst = 1;
+    m_prefetchLast = 0;
 
-    //read in the level file and add the appropriate entities
-    std::ifstream file(fileName);
-    if (!file) {
-        std::cerr << "Could not load config.txt file!\n";
-        exit(-1);
-    }
-
-    std::string head;
-    while (file >> head) {
-        if (head == "Tile") {
-            std::string name;
-            float x, y;
-            file >> name >> x >> y;
-            auto tile = m_entityManager.addEntity("tile");
-            tile->addComponent<CAnimation>(
-                m_game->assets().getAnimation(name), true
-            );
-            tile->addComponent<CTransform>(
-                gridToMidPixel(x, y, tile),
-                Vec2(0, 0),
-                Vec2(4, 4),
-                0
-            );
-            tile->addComponent<CBoundingBox>(m_gridSize);
-        }
-        else if (head == "Dec") {
-            std::string name;
-            float x, y;
-            file >> name >> x >> y;
-            auto dec = m_entityManager.addEntity("dec");
-            dec->addComponent<CAnimation>(
-                m_game->assets().getAnimation(name), true
-            );
-            dec->addComponent<CTransform>(
-                gridToMidPixel(x, y, dec),
-                Vec2(0, 0),
-                Vec2(4, 4),
-                0
+    // text levels are parsed in full and compiled ones are mapped, either
+    // way the level's textures are loaded in one go before any entity
+    // needs them
+    setLoadProgress(0.0f);
+    // this may run on a loading thread, so the caller decides what a
+    // level that does not open means
+    if (!m_streamer.open(fileName, &m_game->loadProfiler())) {
+        return false;
+    }
+    const LevelFile& level = m_streamer.level();
+    setLoadProgress(0.2f);
+
+    for (size_t i = 0; i < level.layerCount(); i++) {
+        m_backgroundLayers.push_back(std::make_shared<BackgroundLayer>(
+            level.layer(i).name, level.layer(i).parallax
+        ));
+    }
+
+    const LevelPlayer* player = level.player();
+    if (player) {
+        m_playerConfig.X = player->x;
+        m_playerConfig.Y = player->y;
+        m_playerConfig.CX = player->cx;
+        m_playerConfig.CY = player->cy;
+        m_playerConfig.SPEED = player->speed;
+        m_playerConfig.JUMP = player->jump;
+        m_playerConfig.MAXSPEED = player->maxSpeed;
+        m_playerConfig.GRAVITY = player->gravity;
+        m_playerConfig.WEAPON = player->weapon;
+        m_anim.weapon = m_game->assets().getAnimationId(m_playerConfig.WEAPON);
+    }
+
+    // names are only looked up once per tile type, not once per tile
+    m_typeAnimations.resize(level.typeCount());
+    for (size_t i = 0; i < level.typeCount(); i++) {
+        m_typeAnimations[i] = m_game->assets().getAnimationId(level.type(i).animation);
+    }
+
+    // the level's asset set: everything it places plus everything the
+    // game logic can switch to
+    std::vector<AssetId> animations = {
+        m_anim.stand, m_anim.air, m_anim.run,
+        m_anim.standShoot, m_anim.airShoot, m_anim.runShoot,
+        m_anim.brick, m_anim.brickDebris, m_anim.question,
+        m_anim.questionHit, m_anim.coinSpin
+    };
+    if (m_anim.weapon != NO_ASSET) {
+        animations.push_back(m_anim.weapon);
+    }
+    animations.insert(animations.end(), m_typeAnimations.begin(), m_typeAnimations.end());
+    m_requiredAssets = animations;
+    setLoadProgress(0.6f);
+
+    LoadTimer buildTimer;
+    buildColliders();
+    setLoadProgress(0.8f);
+    if (player) {
+        spawnPlayer();
+        sStreaming();
+        captureSnapshot();
+    }
+    m_game->loadProfiler().add(
+        LoadPhase::LEVEL_BUILD, fileName, buildTimer.seconds(), 0, level.tileCount()
+    );
+    setLoadProgress(1.0f);
+
+    // a loading scene's worker must not upload textures, the loading
+    // scene finishes on the main thread when it hands this scene over
+    if (!m_loadProgress) {
+        finishLoading();
+    }
+    return true;
+}
+
+void Scene_Play::finishLoading() {
+    m_game->requireAssets(m_requiredAssets);
+
+    // decorations are a handful of vertices each, so they are baked for
+    // the whole level up front and only the tiles are streamed; without
+    // textures they are skipped, they never affect the game
+    if (m_game->assets().isMetadataOnly()) {
+        return;
+    }
+    LoadTimer timer;
+    const LevelFile& level = m_streamer.level();
+    const LevelTile* tiles = level.tiles();
+    for (size_t i = 0; i < level.tileCount(); i++) {
+        const LevelType& type = level.type(tiles[i].type);
+        if (type.kind == LevelTileKind::DECORATION) {
+            addDecoration(
+                *m_backgroundLayers[type.layer],
+                m_typeAnimations[tiles[i].type], tiles[i].x, tiles[i].y
             );
         }
-        else if (head == "Player") {
-            file >> m_playerConfig.X >> m_playerConfig.Y
-                >> m_playerConfig.CX >> m_playerConfig.CY
-                >> m_playerConfig.SPEED
-                >> m_playerConfig.JUMP
-                >> m_playerConfig.MAXSPEED
-                >> m_playerConfig.GRAVITY
-                >> m_playerConfig.WEAPON;
-            spawnPlayer();
+    }
+    m_game->loadProfiler().add(LoadPhase::LEVEL_BUILD, "decorations", timer.seconds());
+}
+
+void Scene_Play::setLoadProgress(float progress) {
+    if (m_loadProgress) {
+        *m_loadProgress = progress;
+    }
+}
+
+// only tiles placed on whole grid cells are merged into colliders
+static bool onGrid(float x, float y) {
+    return x == std::floor(x) && y == std::floor(y);
+}
+
+void Scene_Play::buildColliders() {
+    const LevelFile& level = m_streamer.level();
+    m_typeMerged.resize(level.typeCount());
+    for (size_t i = 0; i < level.typeCount(); i++) {
+        // bricks and question blocks change when hit, so they keep their own box
+        m_typeMerged[i] = level.type(i).kind == LevelTileKind::TILE
+            && m_typeAnimations[i] != m_anim.brick
+            && m_typeAnimations[i] != m_anim.question;
+    }
+
+    std::vector<std::pair<int, int>> cells;
+    const LevelTile* tiles = level.tiles();
+    for (size_t i = 0; i < level.tileCount(); i++) {
+        if (m_typeMerged[tiles[i].type] && onGrid(tiles[i].x, tiles[i].y)) {
+            cells.push_back({ (int)tiles[i].x, (int)tiles[i].y });
         }
-        else {
-            std::cerr << "head to " << head << "\n";
-            std::cerr << "The config file format is incorrect!\n";
-            exit(-1);
+    }
+    m_colliders = Physics::MergeCells(cells);
+
+    m_chunkColliders.assign(m_streamer.chunkCount(), std::vector<size_t>());
+    m_activeColliders.clear();
+    for (size_t i = 0; i < m_colliders.size(); i++) {
+        const GridRect& rect = m_colliders[i];
+        size_t first = m_streamer.chunkOf((float)rect.x);
+        size_t last = m_streamer.chunkOf((float)(rect.x + rect.width - 1));
+        for (size_t chunk = first; chunk <= last && chunk < m_chunkColliders.size(); chunk++) {
+            m_chunkColliders[chunk].push_back(i);
         }
     }
 }
 
+std::shared_ptr<Entity> Scene_Play::addCollider(const GridRect& rect) {
+    auto collider = m_entityManager.addEntity("collider");
+    collider->addComponent<CTransform>(
+        Vec2(
+            (rect.x + rect.width / 2.0f) * m_gridSize.x,
+            height() - (rect.y + rect.height / 2.0f) * m_gridSize.y
+        ),
+        Vec2(0, 0),
+        Vec2(1, 1),
+        0
+    );
+    collider->addComponent<CBoundingBox>(
+        Vec2(rect.width * m_gridSize.x, rect.height * m_gridSize.y)
+    );
+    return collider;
+}
+
+void Scene_Play::addTile(const ChunkTile& chunkTile, size_t chunk) {
+    // tiles changed before their chunk was unloaded come back as they were left
+    TileChange change = m_streamer.change(chunkTile.record);
+    if (change == TileChange::BROKEN) {
+        return;
+    }
+    AssetId animation = change == TileChange::HIT
+        ? m_anim.questionHit : m_typeAnimations[chunkTile.type];
+
+    auto tile = m_entityManager.addEntity("tile");
+    tile->addComponent<CAnimation>(
+        m_game->assets().getAnimation(animation), true, RenderLayer::TILE
+    );
+    tile->addComponent<CTransform>(
+        gridToMidPixel(chunkTile.x, chunkTile.y, tile),
+        Vec2(0, 0),
+        Vec2(4, 4),
+        0
+    );
+    if (!m_typeMerged[chunkTile.type] || !onGrid(chunkTile.x, chunkTile.y)) {
+        tile->addComponent<CBoundingBox>(m_gridSize);
+    }
+    tile->addComponent<CChunk>(chunk, chunkTile.record);
+    m_activeChunks[chunk].push_back(tile);
+}
+
+void Scene_Play::addDecoration(BackgroundLayer& layer, AssetId animation, float x, float y) {
+    // decorations never move or collide, so they are baked into
+    // background meshes instead of becoming entities
+    Animation decoration = m_game->assets().getAnimation(animation);
+    layer.add(
+        &m_game->assets().getTexture(decoration.texture()),
+        decoration.getTextureRect(),
+        gridToMidPixel(x, y, decoration.getSize()),
+        Vec2(4, 4)
+    );
+}
+
+float Scene_Play::cameraX() const {
+    // the view is centered on the player once it is far enough right
+    float playerX = m_player->getComponent<CTransform>().pos.x;
+    return std::max(width() / 2.0f, playerX) - width() / 2.0f;
+}
+
+void Scene_Play::activateChunk(size_t chunk) {
+    const std::vector<ChunkTile>& tiles = m_streamer.tiles(chunk);
+    m_activeChunks[chunk].reserve(tiles.size());
+    m_entityManager.reserve(tiles.size());
+    for (auto& tile : tiles) {
+        addTile(tile, chunk);
+    }
+    for (size_t index : m_chunkColliders[chunk]) {
+        auto& active = m_activeColliders[index];
+        if (active.first++ == 0) {
+            active.second = addCollider(m_colliders[index]);
+        }
+    }
+}
+
+void Scene_Play::deactivateChunk(size_t chunk) {
+    for (auto& e : m_activeChunks[chunk]) {
+        e->destroy();
+    }
+    m_activeChunks.erase(chunk);
+    for (size_t index : m_chunkColliders[chunk]) {
+        auto active = m_activeColliders.find(index);
+        if (--active->second.first == 0) {
+            active->second.second->destroy();
+            m_activeColliders.erase(active);
+        }
+    }
+}
+
+void Scene_Play::sStreaming() {
+    if (m_streamer.chunkCount() == 0) {
+        return;
+    }
+    size_t lastChunk = m_streamer.chunkCount() - 1;
+    float gridLeft = cameraX() / m_gridSize.x;
+    float gridRight = (cameraX() + width()) / m_gridSize.x;
+
+    // chunks on screen plus a margin have entities
+    size_t first = m_streamer.chunkOf(gridLeft);
+    size_t last = m_streamer.chunkOf(gridRight);
+    first = first > m_activeMargin ? first - m_activeMargin : 0;
+    last = std::min(last + m_activeMargin, lastChunk);
+
+    for (auto it = m_activeChunks.begin(); it != m_activeChunks.end();) {
+        size_t chunk = (it++)->first;
+        if (chunk < first || chunk > last) {
+            deactivateChunk(chunk);
+        }
+    }
+
+    // the level is played left to right, so loading runs ahead of the
+    // player and everything behind the margin is dropped
+    // the window only moves every CHUNK_WIDTH columns
+    size_t prefetchLast = std::min(last + m_prefetchAhead, lastChunk);
+    if (first != m_prefetchFirst || prefetchLast != m_prefetchLast) {
+        m_prefetchFirst = first;
+        m_prefetchLast = prefetchLast;
+        m_streamer.prefetch(first, prefetchLast);
+    }
+
+    for (size_t chunk = first; chunk <= last; chunk++) {
+        if (m_activeChunks.find(chunk) == m_activeChunks.end()) {
+            activateChunk(chunk);
+        }
+    }
+}
+
+void Scene_Play::captureSnapshot() {
+    m_snapshot = Snapshot();
+    m_snapshot.entities = m_entityManager.snapshot();
+    m_snapshot.frame = m_currentFrame;
+    m_snapshot.score = m_score;
+
+    // entities are referred to by their position in the snapshot, which
+    // is where restoring puts them
+    std::unordered_map<size_t, size_t> index;
+    for (size_t i = 0; i < m_snapshot.entities.entities.size(); i++) {
+        index[m_snapshot.entities.entities[i].id] = i;
+    }
+    m_snapshot.player = index.at(m_player->id());
+    for (auto& [chunk, entities] : m_activeChunks) {
+        std::vector<size_t> indices;
+        indices.reserve(entities.size());
+        for (auto& e : entities) {
+            if (e->isActive()) {
+                indices.push_back(index.at(e->id()));
+            }
+        }
+        m_snapshot.chunks.push_back({ chunk, std::move(indices) });
+    }
+    for (auto& [collider, active] : m_activeColliders) {
+        m_snapshot.colliders.push_back(
+            { collider, active.first, index.at(active.second->id()) }
+        );
+    }
+}
+
+void Scene_Play::restart() {
+    m_restarts++;
+    // keys still held down keep working after the restart, shooting
+    // included, so the whole input state carries over
+    CInput input = m_player->getComponent<CInput>();
+
+    m_entityManager.restore(m_snapshot.entities);
+    const EntityVec& entities = m_entityManager.getEntities();
+    m_player = entities[m_snapshot.player];
+    m_player->getComponent<CInput>() = input;
+
+    m_activeChunks.clear();
+    for (auto& [chunk, indices] : m_snapshot.chunks) {
+        EntityVec& chunkEntities = m_activeChunks[chunk];
+        chunkEntities.reserve(indices.size());
+        for (size_t i : indices) {
+            chunkEntities.push_back(entities[i]);
+        }
+    }
+    m_activeColliders.clear();
+    for (auto& [collider, count, entity] : m_snapshot.colliders) {
+        m_activeColliders[collider] = { count, entities[entity] };
+    }
+
+    // broken bricks and hit blocks come back, chunks that are still
+    // loaded are reused as they are
+    m_streamer.clearChanges();
+    m_currentFrame = m_snapshot.frame;
+    m_score = m_snapshot.score;
+    m_scoreText.setString("Score: " + std::to_string(m_score));
+}
+
+size_t Scene_Play::restartCount() const {
+    return m_restarts;
+}
+
+int Scene_Play::score() const {
+    return m_score;
+}
+
+void Scene_Play::observe(float* out, int gridWidth, int gridHeight, size_t maxEntities) {
+    const CTransform& transform = m_player->getComponent<CTransform>();
+    // grid units with y pointing up, like level files
+    float playerX = transform.pos.x / m_gridSize.x;
+    float playerY = (height() - transform.pos.y) / m_gridSize.y;
+    *out++ = playerX;
+    *out++ = playerY;
+    *out++ = transform.velocity.x;
+    *out++ = transform.velocity.y;
+    *out++ = m_player->getComponent<CInput>().canJump ? 1.0f : 0.0f;
+    *out++ = transform.scale.x < 0 ? 1.0f : -1.0f; // facing right or left
+    *out++ = (float)m_score;
+    *out++ = (float)m_currentFrame;
+
+    // row major from the top left cell of the window
+    float* grid = out;
+    std::fill(grid, grid + gridWidth * gridHeight, 0.0f);
+    int left = (int)std::floor(playerX) - gridWidth / 2;
+    int top = (int)std::floor(playerY) + gridHeight / 2;
+    for (const char* tag : { "tile", "collider" }) {
+        for (auto& e : m_entityManager.getEntities(tag)) {
+            if (!e->isActive() || !e->hasComponent<CBoundingBox>()) {
+                continue;
+            }
+            const Vec2& pos = e->getComponent<CTransform>().pos;
+            const Vec2& half = e->getComponent<CBoundingBox>().halfSize;
+            // cells the box covers, shrunk a little so touching edges
+            // do not count as the neighbouring cell
+            int x0 = (int)std::floor((pos.x - half.x + 1) / m_gridSize.x) - left;
+            int x1 = (int)std::floor((pos.x + half.x - 1) / m_gridSize.x) - left;
+            int y0 = top - (int)std::floor((height() - pos.y + half.y - 1) / m_gridSize.y);
+            int y1 = top - (int)std::floor((height() - pos.y - half.y + 1) / m_gridSize.y);
+            for (int y = std::max(y0, 0); y <= std::min(y1, gridHeight - 1); y++) {
+                for (int x = std::max(x0, 0); x <= std::min(x1, gridWidth - 1); x++) {
+                    grid[y * gridWidth + x] = 1.0f;
+                }
+            }
+        }
+    }
+    out += gridWidth * gridHeight;
+
+    // kind, then offset from the player in grid units, zero padded
+    float* entities = out;
+    std::fill(entities, entities + maxEntities * 3, 0.0f);
+    size_t count = 0;
+    for (const char* tag : { "bullet", "coin" }) {
+        float kind = tag[0] == 'b' ? 1.0f : 2.0f;
+        for (auto& e : m_entityManager.getEntities(tag)) {
+            if (count == maxEntities) {
+                break;
+            }
+            if (!e->isActive()) {
+                continue;
+            }
+            const Vec2& pos = e->getComponent<CTransform>().pos;
+            entities[count * 3] = kind;
+            entities[count * 3 + 1] = pos.x / m_gridSize.x - playerX;
+            entities[count * 3 + 2] = (height() - pos.y) / m_gridSize.y - playerY;
+            count++;
+        }
+    }
+}
+
+void Scene_Play::reloadLevel() {
+    // the player keeps where it is and what it is doing, and the camera
+    // follows the player, so editing a level does not throw you back
+    // to the start
+    CTransform transform = m_player->getComponent<CTransform>();
+    CInput input = m_player->getComponent<CInput>();
+    CState state = m_player->getComponent<CState>();
+    CAnimation animation = m_player->getComponent<CAnimation>();
+
+    loadLevel(m_levelPath);
+
+    m_player->getComponent<CTransform>() = transform;
+    m_player->getComponent<CInput>() = input;
+    m_player->getComponent<CState>() = state;
+    m_player->getComponent<CAnimation>() = animation;
+}
+
+void Scene_Play::onFileChanged(const std::string& path) {
+    // a changed assets config can resize animations that are baked
+    // into the background layers
+    std::error_code error;
+    if (std::filesystem::equivalent(path, m_levelPath, error)
+        || m_game->assets().isManifest(path)) {
+        // a level that does not parse, e.g. half way through an edit,
+        // keeps the current one running; the error says where it broke
+        LevelFile check;
+        if (!check.open(m_levelPath)) {
+            std::cerr << "keeping the current level\n";
+            return;
+        }
+        reloadLevel();
+        std::cout << "reloaded " << m_levelPath << "\n";
+    }
+}
+
 void Scene_Play::spawnPlayer() {
     m_player = m_entityManager.addEntity("player");
     m_player->addComponent<CAnimation>(
-        m_game->assets().getAnimation("Stand"),
+        m_game->assets().getAnimation(m_anim.stand),
         true
     );
     m_player->addComponent<CTransform>(
@@ -152,7 +581,7 @@ void Scene_Play::spawnPlayer() {
 void Scene_Play::spawnBullet(std::shared_ptr<Entity> entity) {
     auto bullet = m_entityManager.addEntity("bullet");
     bullet->addComponent<CAnimation>(
-        m_game->assets().getAnimation(m_playerConfig.WEAPON),
+        m_game->assets().getAnimation(m_anim.weapon),
         true
     );
     bullet->addComponent<CTransform>(
@@ -173,17 +602,39 @@ void Scene_Play::addScore(int x) {
 }
 
 void Scene_Play::update() {
+    step();
+    {
+        PROFILE_SCOPE(RENDER);
+        sRender();
+    }
+}
+
+void Scene_Play::step() {
     m_entityManager.update();
 
     if (!m_pause) {
-        sMovement();
-        sLifespan();
-        sCollision();
+        {
+            PROFILE_SCOPE(MOVEMENT);
+            sMovement();
+        }
+        {
+            PROFILE_SCOPE(LIFESPAN);
+            sLifespan();
+        }
+        {
+            PROFILE_SCOPE(COLLISION);
+            sCollision();
+        }
         m_currentFrame++;
     }
-    sAnimation();
-    sRender();
-     
+    {
+        PROFILE_SCOPE(STREAMING);
+        sStreaming();
+    }
+    {
+        PROFILE_SCOPE(ANIMATION);
+        sAnimation();
+    }
 }
 
 void Scene_Play::sMovement() {
@@ -248,20 +699,25 @@ void Scene_Play::sLifespan() {
 
 void Scene_Play::sCollision() {
     // Check for bullet and tile collisions
+    // merged colliders have no animation, and tiles merged into them no box
     for (auto b : m_entityManager.getEntities("bullet")) {
-        for (auto t : m_entityManager.getEntities("tile")) {
-            Vec2 overlap = m_worldPhysics.GetOverlap(b, t);
-            Vec2 pOverlap = m_worldPhysics.GetPreviousOverlap(b, t);
-            if (0 < overlap.y && -m_gridSize.x < overlap.x) {
-                if (0 <= overlap.x && pOverlap.x <= 0) {
-                    if (t->getComponent<CAnimation>().animation.getName() == "Brick") {
-                        
-                        spawnBrickDebris(t);
+        for (auto& tag : { "tile", "collider" }) {
+            for (auto t : m_entityManager.getEntities(tag)) {
+                if (!t->hasComponent<CBoundingBox>()) {
+                    continue;
+                }
+                Vec2 overlap = m_worldPhysics.GetOverlap(b, t);
+                Vec2 pOverlap = m_worldPhysics.GetPreviousOverlap(b, t);
+                if (0 < overlap.y && -m_gridSize.x < overlap.x) {
+                    if (0 <= overlap.x && pOverlap.x <= 0) {
+                        if (t->getComponent<CAnimation>().animation.id() == m_anim.brick) {
+
+                            spawnBrickDebris(t);
+                        }
+                        b->destroy();
                     }
-                    b->destroy();
                 }
             }
-            
         }
     }
 
@@ -279,58 +735,66 @@ void Scene_Play::sCollision() {
     m_player->getComponent<CGravity>().gravity = m_playerConfig.GRAVITY;
 
     //player / tile collisions and resolutions
-    for (auto t : m_entityManager.getEntities("tile")) {
-        Vec2 overlap = m_worldPhysics.GetOverlap(m_player, t);
-        Vec2 pOverlap = m_worldPhysics.GetPreviousOverlap(m_player, t);
-        // check if player is on air
-        // check tiles being below player
-        float dy = t->getComponent<CTransform>().pos.y -
-            m_player->getComponent<CTransform>().pos.y;
-        if (0 < overlap.x && -m_gridSize.y < overlap.y && dy > 0) {
-            if (0 <= overlap.y && pOverlap.y <= 0) {
-                // stand on tile
-                m_player->getComponent<CInput>().canJump = true;
-                m_player->getComponent<CGravity>().gravity = 0;
-                m_player->getComponent<CTransform>().velocity.y = 0;
-                // collision resolution
-                m_player->getComponent<CTransform>().pos.y -= overlap.y;
+    for (auto& tag : { "tile", "collider" }) {
+        for (auto t : m_entityManager.getEntities(tag)) {
+            if (!t->hasComponent<CBoundingBox>()) {
+                continue;
             }
-        }
-        // check if player hits the tile
-        if (0 < overlap.x && -m_gridSize.y < overlap.y && dy < 0) {
-            if (0 <= overlap.y && pOverlap.y <= 0) {
-                m_player->getComponent<CTransform>().pos.y += overlap.y;
-                m_player->getComponent<CTransform>().velocity.y = 0;
-                if (t->getComponent<CAnimation>().animation.getName() == "Question") {
-                    t->getComponent<CAnimation>().animation = 
-                        m_game->assets().getAnimation("QuestionHit");
-                    spawnCoin(t);
-                }
-                if (t->getComponent<CAnimation>().animation.getName() == "Brick") {
-                    spawnBrickDebris(t);
+            Vec2 overlap = m_worldPhysics.GetOverlap(m_player, t);
+            Vec2 pOverlap = m_worldPhysics.GetPreviousOverlap(m_player, t);
+            // check if player is on air
+            // check tiles being below player
+            float dy = t->getComponent<CTransform>().pos.y -
+                m_player->getComponent<CTransform>().pos.y;
+            if (0 < overlap.x && -m_gridSize.y < overlap.y && dy > 0) {
+                if (0 <= overlap.y && pOverlap.y <= 0) {
+                    // stand on tile
+                    m_player->getComponent<CInput>().canJump = true;
+                    m_player->getComponent<CGravity>().gravity = 0;
+                    m_player->getComponent<CTransform>().velocity.y = 0;
+                    // collision resolution
+                    m_player->getComponent<CTransform>().pos.y -= overlap.y;
                 }
             }
-        }
-        // check player and tile side collide
-        float dx = t->getComponent<CTransform>().pos.x -
-            m_player->getComponent<CTransform>().pos.x;
-        if (0 < overlap.y && -m_gridSize.x < overlap.x) {
-            if (0 <= overlap.x && pOverlap.x <= 0) {
-                if (dx > 0) {
-                    // tile is right of player
-                    m_player->getComponent<CTransform>().pos.x -= overlap.x;
+            // check if player hits the tile
+            if (0 < overlap.x && -m_gridSize.y < overlap.y && dy < 0) {
+                if (0 <= overlap.y && pOverlap.y <= 0) {
+                    m_player->getComponent<CTransform>().pos.y += overlap.y;
+                    m_player->getComponent<CTransform>().velocity.y = 0;
+                    if (t->getComponent<CAnimation>().animation.id() == m_anim.question) {
+                        t->getComponent<CAnimation>().animation = 
+                            m_game->assets().getAnimation(m_anim.questionHit);
+                        m_streamer.setChange(
+                            t->getComponent<CChunk>().record, TileChange::HIT
+                        );
+                        spawnCoin(t);
+                    }
+                    if (t->getComponent<CAnimation>().animation.id() == m_anim.brick) {
+                        spawnBrickDebris(t);
+                    }
                 }
-                else {
-                    // tile is left of player
-                    m_player->getComponent<CTransform>().pos.x += overlap.x;
+            }
+            // check player and tile side collide
+            float dx = t->getComponent<CTransform>().pos.x -
+                m_player->getComponent<CTransform>().pos.x;
+            if (0 < overlap.y && -m_gridSize.x < overlap.x) {
+                if (0 <= overlap.x && pOverlap.x <= 0) {
+                    if (dx > 0) {
+                        // tile is right of player
+                        m_player->getComponent<CTransform>().pos.x -= overlap.x;
+                    }
+                    else {
+                        // tile is left of player
+                        m_player->getComponent<CTransform>().pos.x += overlap.x;
+                    }
                 }
             }
         }
     }
     //check to see if the player has fallen down a hole
     if (m_player->getComponent<CTransform>().pos.y > height()) {
-        m_player->getComponent<CTransform>().pos =
-            gridToMidPixel(m_playerConfig.X, m_playerConfig.Y, m_player);
+        restart();
+        return;
     }
     //prevent the player walk of the left side of the map
     if (m_player->getComponent<CTransform>().pos.x < 
@@ -351,12 +815,18 @@ void Scene_Play::sDoAction(const Action& action) {
         else if (action.name() == "TOGGLE_GRID") { 
             m_drawDrawGrid = !m_drawDrawGrid; 
         }
+        else if (action.name() == "TOGGLE_PROFILER") {
+            m_drawProfiler = !m_drawProfiler;
+        }
         else if (action.name() == "PAUSE") { 
             setPaused(!m_pause);
         }
         else if (action.name() == "QUIT") { 
             onEnd();
         }
+        else if (action.name() == "RESTART") {
+            restart();
+        }
         else if (action.name() == "JUMP") {
             if (m_player->getComponent<CInput>().canJump) {
                 m_player->getComponent<CInput>().up = true;
@@ -425,29 +895,29 @@ void Scene_Play::sAnimation() {
     
     // change player animation
     if (m_player->getComponent<CState>().changeAnimate) {
-        std::string aniName;
+        AssetId animation = m_anim.stand;
         switch (m_player->getComponent<CState>().state) {
             case PlayerState::STAND:
-                aniName = "Stand";
+                animation = m_anim.stand;
                 break;
             case PlayerState::AIR:
-                aniName = "Air";
+                animation = m_anim.air;
                 break;
             case PlayerState::RUN:
-                aniName = "Run";
+                animation = m_anim.run;
                 break;
             case PlayerState::STANDSHOOT:
-                aniName = "StandShoot";
+                animation = m_anim.standShoot;
                 break;
             case PlayerState::AIRSHOOT:
-                aniName = "AirShoot";
+                animation = m_anim.airShoot;
                 break;
             case PlayerState::RUNSHOOT:
-                aniName = "RunShoot";
+                animation = m_anim.runShoot;
                 break;
         }
         m_player->addComponent<CAnimation>(
-                m_game->assets().getAnimation(aniName), true
+                m_game->assets().getAnimation(animation), true
                 );
     }
 
@@ -465,70 +935,115 @@ void Scene_Play::sAnimation() {
 }
 
 void Scene_Play::onEnd() {
-    m_game->changeScene( "MENU", std::make_shared<Scene_Menu>(m_game));
+    m_hasEnded = true;
+    // instances run side by side by the simulation runner are not the
+    // engine's scene, they just stop
+    if (m_game->isCurrentScene(this)) {
+        m_game->changeScene( "MENU", std::make_shared<Scene_Menu>(m_game));
+    }
+}
+
+std::string Scene_Play::profilerReport() const {
+#ifdef KM_PROFILE
+    const FrameProfiler& profiler = FrameProfiler::instance();
+    std::string report = "ms over " + std::to_string(profiler.frames())
+        + " frames   min    avg    p99\n";
+    for (size_t i = 0; i < FrameProfiler::SECTION_COUNT; i++) {
+        FrameProfiler::Stats stats = profiler.stats((ProfileSection)i);
+        char line[64];
+        std::snprintf(
+            line, sizeof(line), "%-12s %6.2f %6.2f %6.2f\n",
+            FrameProfiler::sectionName((ProfileSection)i),
+            stats.min, stats.avg, stats.p99
+        );
+        report += line;
+    }
+    return report;
+#else
+    return "profiling is compiled out,\nbuild with KM_PROFILE";
+#endif
 }
 
 void Scene_Play::sRender() {
+    // everything is recorded into the engine's frame, which is drawn
+    // once the tick is over (possibly on the render thread)
+    RenderFrame& frame = m_game->frame();
+
     // coloring the background darker so you know that the game is paused
     if (!m_pause) {
-        m_game->window().clear(sf::Color(100, 100, 255));
+        frame.clearColor = sf::Color(100, 100, 255);
     }
     else {
-        m_game->window().clear(sf::Color(50, 50, 150));
+        frame.clearColor = sf::Color(50, 50, 150);
     }
 
     // set the viewport of the window to be centered on the player if it's far enough right
-    auto& pPos = m_player->getComponent<CTransform>().pos;
-    float windowCenterX = std::max(m_game->window().getSize().x / 2.0f, pPos.x);
-    sf::View view = m_game->window().getView();
-    view.setCenter(windowCenterX, m_game->window().getSize().y - view.getCenter().y);
-    m_game->window().setView(view);
-
-    // draw score text
-    m_scoreText.setPosition(windowCenterX - (m_game->window().getSize().x / 2) + 25
-       , 25);
+    float windowCenterX = cameraX() + width() / 2.0f;
+    sf::View& view = frame.view;
+    view.setCenter(windowCenterX, height() - view.getCenter().y);
 
-    m_game->window().draw(m_scoreText);
+    // background layers scroll with their own parallax
+    if (m_drawTextures) {
+        float left = cameraX();
+        for (auto& layer : m_backgroundLayers) {
+            frame.addLayer(layer, layer->offset(left));
+        }
+    }
 
-    // draw all Entity textures / animations
+    // queue all Entity textures / animations, sorted by layer and texture
     if (m_drawTextures) {
         for (auto e : m_entityManager.getEntities()) {
-            auto& transform = e->getComponent<CTransform>();
             if (e->hasComponent<CAnimation>()) {
-                auto& animation = e->getComponent<CAnimation>().animation;
-                animation.getSprite().setRotation(transform.angle);
-                animation.getSprite().setPosition(
-                    transform.pos.x, transform.pos.y
-                );
-                animation.getSprite().setScale(
-                    transform.scale.x, transform.scale.y
+                auto& transform = e->getComponent<CTransform>();
+                auto& component = e->getComponent<CAnimation>();
+                auto& animation = component.animation;
+                // the null renderer only counts, batching goes by texture id
+                const sf::Texture* texture = m_game->assets().isMetadataOnly()
+                    ? nullptr : &m_game->assets().getTexture(animation.texture());
+                frame.queue.submit(
+                    component.layer,
+                    (std::uint32_t)e->id(),
+                    (std::uint32_t)animation.texture(),
+                    texture,
+                    animation.getTextureRect(),
+                    transform.pos,
+                    transform.scale,
+                    transform.angle
                 );
-                m_game->window().draw(animation.getSprite());
             }
         }
     }
 
-    // draw all Entity collision bounding boxes with a rectangle shape
+    // the hud is drawn on top of every entity layer
+    m_scoreText.setPosition(windowCenterX - (width() / 2) + 25, 25);
+    frame.texts.push_back(m_scoreText);
+    if (m_drawProfiler) {
+        m_profilerText.setString(profilerReport());
+        m_profilerText.setPosition(windowCenterX + (width() / 2) - 400, 25);
+        frame.texts.push_back(m_profilerText);
+    }
+
+    // draw all Entity collision bounding boxes with a rectangle outline
     if (m_drawCollision) {
         for (auto e : m_entityManager.getEntities()) {
             if (e->hasComponent<CBoundingBox>()) {
                 auto& box = e->getComponent<CBoundingBox>();
                 auto& transform = e->getComponent<CTransform>();
-                sf::RectangleShape rect;
-                rect.setSize(sf::Vector2f(box.size.x-1, box.size.y-1));
-                rect.setOrigin(sf::Vector2f(box.halfSize.x, box.halfSize.y));
-                rect.setPosition(transform.pos.x, transform.pos.y);
-                rect.setFillColor(sf::Color(0, 0, 0, 0));
-                rect.setOutlineColor(sf::Color::White);
-                rect.setOutlineThickness(1);
-                m_game->window().draw(rect);
+                float left = transform.pos.x - box.halfSize.x;
+                float top = transform.pos.y - box.halfSize.y;
+                float right = left + box.size.x - 1;
+                float bottom = top + box.size.y - 1;
+                frame.addLine({ left, top }, { right, top }, sf::Color::White);
+                frame.addLine({ right, top }, { right, bottom }, sf::Color::White);
+                frame.addLine({ right, bottom }, { left, bottom }, sf::Color::White);
+                frame.addLine({ left, bottom }, { left, top }, sf::Color::White);
             }
         }
     }
 
     // draw the grid so that can easily debug
     if (m_drawDrawGrid) {
-        float leftX = m_game->window().getView().getCenter().x - width() / 2.0;
+        float leftX = view.getCenter().x - width() / 2.0;
         float rightX = leftX + width() + m_gridSize.x;
         float nextGridX = leftX - ((int)leftX % (int)m_gridSize.x);
 
@@ -544,7 +1059,7 @@ void Scene_Play::sRender() {
                 std::string yCell = std::to_string((int)y / (int)m_gridSize.y);
                 m_gridText.setString("(" + xCell + "," + yCell + ")");
                 m_gridText.setPosition(x+3, height()-y-m_gridSize.y+2);
-                m_game->window().draw(m_gridText);
+                frame.texts.push_back(m_gridText);
             }
         }
     }
@@ -568,7 +1083,7 @@ void Scene_Play::changePlayerStateTo(PlayerState s) {
 
 void Scene_Play::spawnCoin(std::shared_ptr<Entity> tile) {
     auto coin = m_entityManager.addEntity("coin");
-    coin->addComponent<CAnimation>(m_game->assets().getAnimation("CoinSpin"), true);
+    coin->addComponent<CAnimation>(m_game->assets().getAnimation(m_anim.coinSpin), true);
     coin->addComponent<CTransform>(
         Vec2(
             tile->getComponent<CTransform>().pos.x,
@@ -582,7 +1097,8 @@ void Scene_Play::spawnCoin(std::shared_ptr<Entity> tile) {
 }
 
 void Scene_Play::spawnBrickDebris(std::shared_ptr<Entity> tile) {
+    m_streamer.setChange(tile->getComponent<CChunk>().record, TileChange::BROKEN);
     tile->getComponent<CAnimation>().animation = 
-        m_game->assets().getAnimation("BrickDebris");
+        m_game->assets().getAnimation(m_anim.brickDebris);
     tile->addComponent<CLifespan>(10, m_currentFrame);
 }
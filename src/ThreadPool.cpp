@@ -0,0 +1,107 @@
+#include "ThreadPool.h"
+#include "FrameProfiler.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        m_threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_workAvailable.notify_all();
+    // tasks still queued are run first
+    for (auto& t : m_threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t queue;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        queue = m_nextQueue;
+        m_nextQueue = (m_nextQueue + 1) % m_queues.size();
+        m_unfinished++;
+        // counted under m_mutex so a worker going to sleep cannot miss it,
+        // and before the push so a worker taking the task right away
+        // never brings the count below zero
+        m_queued++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_queues[queue]->mutex);
+        m_queues[queue]->tasks.push_back(std::move(task));
+    }
+    m_workAvailable.notify_one();
+}
+
+bool ThreadPool::take(size_t worker, std::function<void()>& task) {
+    // own deque from the back, the most recently added task
+    {
+        Queue& own = *m_queues[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            m_queued--;
+            return true;
+        }
+    }
+    // other deques from the front, the task their owner would run last
+    for (size_t i = 1; i < m_queues.size(); i++) {
+        Queue& victim = *m_queues[(worker + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t worker) {
+    TraceRecorder::instance().setThreadName("worker " + std::to_string(worker));
+    // tasks run whole scenes side by side, timing them into the engine's
+    // frame profile would mix every instance together
+    FrameProfiler::setThreadProfiler(nullptr);
+    while (true) {
+        std::function<void()> task;
+        if (take(worker, task)) {
+            task();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_unfinished == 0) {
+                m_allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_workAvailable.wait(lock, [this] { return m_queued > 0 || !m_running; });
+        if (m_queued == 0 && !m_running) {
+            break;
+        }
+    }
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_allDone.wait(lock, [this] { return m_unfinished == 0; });
+}
+
+size_t ThreadPool::size() const {
+    return m_threads.size();
+}
@@ -0,0 +1,84 @@
+#include "Tokenizer.h"
+
+#include <charconv>
+#include <iostream>
+
+Tokenizer::Tokenizer(const std::string& path, const char* data, size_t size)
+    : m_path(path)
+    , m_pos(data)
+    , m_end(data + size)
+    , m_lineStart(data)
+{
+}
+
+void Tokenizer::skipWhitespace() {
+    while (m_pos < m_end) {
+        char c = *m_pos;
+        if (c == '\n') {
+            m_line++;
+            m_lineStart = m_pos + 1;
+        }
+        else if (c != ' ' && c != '\t' && c != '\r') {
+            break;
+        }
+        m_pos++;
+    }
+}
+
+bool Tokenizer::next(std::string_view& token) {
+    skipWhitespace();
+    if (m_pos == m_end) {
+        return false;
+    }
+    m_tokenLine = m_line;
+    m_tokenColumn = (size_t)(m_pos - m_lineStart) + 1;
+    const char* start = m_pos;
+    while (m_pos < m_end && *m_pos != ' ' && *m_pos != '\t'
+        && *m_pos != '\r' && *m_pos != '\n') {
+        m_pos++;
+    }
+    token = std::string_view(start, (size_t)(m_pos - start));
+    return true;
+}
+
+bool Tokenizer::read(std::string_view& value, const char* what) {
+    // the value belongs right after the previous token
+    size_t line = m_line;
+    size_t column = (size_t)(m_pos - m_lineStart) + 1;
+    if (!next(value) || m_tokenLine != line) {
+        m_tokenLine = line;
+        m_tokenColumn = column;
+        return error(std::string("expected ") + what);
+    }
+    return true;
+}
+
+bool Tokenizer::read(float& value, const char* what) {
+    std::string_view token;
+    if (!read(token, what)) {
+        return false;
+    }
+    auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+        return error(std::string("expected ") + what + ", got '" + std::string(token) + "'");
+    }
+    return true;
+}
+
+bool Tokenizer::read(int& value, const char* what) {
+    std::string_view token;
+    if (!read(token, what)) {
+        return false;
+    }
+    auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    if (result.ec != std::errc() || result.ptr != token.data() + token.size()) {
+        return error(std::string("expected ") + what + ", got '" + std::string(token) + "'");
+    }
+    return true;
+}
+
+bool Tokenizer::error(const std::string& message) const {
+    std::cerr << m_path << ":" << m_tokenLine << ":" << m_tokenColumn
+        << ": " << message << "\n";
+    return false;
+}
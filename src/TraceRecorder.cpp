@@ -0,0 +1,161 @@
+#include "TraceRecorder.h"
+#include "FixedName.h"
+#include "Json.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+TraceRecorder::~TraceRecorder() {
+    // blocks are chained from the first one, unlink them iteratively
+    for (auto& thread : m_threads) {
+        Block* block = thread->first->next;
+        while (block) {
+            Block* next = block->next;
+            delete block;
+            block = next;
+        }
+    }
+}
+
+TraceRecorder& TraceRecorder::instance() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+void TraceRecorder::start() {
+    m_start = std::chrono::steady_clock::now();
+    m_recording = true;
+}
+
+bool TraceRecorder::isRecording() const {
+    return m_recording.load(std::memory_order_relaxed);
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::buffer() {
+    // registered on a thread's first event and kept after it exits,
+    // so its events can still be written
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_threads.push_back(std::make_unique<ThreadBuffer>());
+        buffer = m_threads.back().get();
+        buffer->id = m_threads.size();
+        buffer->name = m_threads.size() == 1 ? "main" : "thread " + std::to_string(buffer->id);
+        buffer->first = std::make_unique<Block>();
+        buffer->last = buffer->first.get();
+    }
+    return *buffer;
+}
+
+TraceRecorder::Event& TraceRecorder::append(char phase, const char* category, const char* name) {
+    ThreadBuffer& thread = buffer();
+    Block* block = thread.last;
+    size_t index = block->count.load(std::memory_order_relaxed);
+    if (index == BLOCK_SIZE) {
+        Block* next = new Block();
+        block->next.store(next, std::memory_order_release);
+        thread.last = next;
+        block = next;
+        index = 0;
+    }
+    Event& event = block->events[index];
+    event.phase = phase;
+    // names longer than the field are cut, the timeline only shows a few
+    // dozen characters anyway
+    copyName(event.category, category);
+    copyName(event.name, name);
+    event.series[0] = '\0';
+    event.start = 0;
+    event.duration = 0;
+    event.value = 0;
+    return event;
+}
+
+double TraceRecorder::microseconds(std::chrono::steady_clock::time_point time) const {
+    return std::chrono::duration<double, std::micro>(time - m_start).count();
+}
+
+void TraceRecorder::setThreadName(const std::string& name) {
+    // threads that never record an event get no buffer
+    if (!isRecording()) {
+        return;
+    }
+    ThreadBuffer& thread = buffer();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    thread.name = name;
+}
+
+void TraceRecorder::span(
+    const char* category,
+    const char* name,
+    std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end
+) {
+    if (!isRecording()) {
+        return;
+    }
+    Event& event = append('X', category, name);
+    event.start = microseconds(start);
+    event.duration = microseconds(end) - event.start;
+    // publish, write() only reads events below count
+    Block* block = buffer().last;
+    block->count.fetch_add(1, std::memory_order_release);
+}
+
+void TraceRecorder::counter(const char* name, const std::string& series, std::int64_t value) {
+    if (!isRecording()) {
+        return;
+    }
+    Event& event = append('C', "counter", name);
+    copyName(event.series, series);
+    event.start = microseconds(std::chrono::steady_clock::now());
+    event.value = value;
+    Block* block = buffer().last;
+    block->count.fetch_add(1, std::memory_order_release);
+}
+
+bool TraceRecorder::write(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Could not write trace " << path << "!\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // thread names are metadata records, not counted as events
+    size_t events = 0;
+    bool first = true;
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    for (auto& thread : m_threads) {
+        file << (first ? "\n" : ",\n")
+            << "{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": " << thread->id
+            << ", \"args\": {\"name\": " << jsonString(thread->name) << "}}";
+        first = false;
+
+        for (Block* block = thread->first.get(); block;
+            block = block->next.load(std::memory_order_acquire)) {
+            size_t count = block->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++) {
+                const Event& event = block->events[i];
+                file << ",\n{\"ph\": \"" << event.phase
+                    << "\", \"cat\": " << jsonString(event.category)
+                    << ", \"name\": " << jsonString(event.name)
+                    << ", \"pid\": 1, \"tid\": " << thread->id
+                    << ", \"ts\": " << event.start;
+                if (event.phase == 'X') {
+                    file << ", \"dur\": " << event.duration << "}";
+                }
+                else {
+                    file << ", \"args\": {" << jsonString(event.series)
+                        << ": " << event.value << "}}";
+                }
+                events++;
+            }
+        }
+    }
+    file << "\n]}\n";
+    std::cout << "wrote " << events << " trace events to " << path << "\n";
+    return true;
+}
@@ -1,7 +1,268 @@
 #include <SFML/Graphics.hpp>
+#include "Assets.h"
 #include "GameEngine.h"
+#include "InputScript.h"
+#include "LevelFile.h"
+#include "LevelGenerator.h"
+#include "MappedFile.h"
+#include "Tokenizer.h"
 
-int main() {
-    GameEngine g("config/assets.txt");
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+// parse a level or assets config over and over and print throughput,
+// next to plain ifstream tokenizing for comparison
+static int benchParse(const std::string& path, size_t iterations) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Could not open " << path << "!\n";
+        return -1;
+    }
+    const char* data = (const char*)file.data();
+    std::string_view head;
+    Tokenizer(path, data, file.size()).next(head);
+    bool isLevel = head == "Tile" || head == "Dec" || head == "Layer" || head == "Player";
+
+    auto measure = [&](const char* label, auto parse) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            if (!parse()) {
+                exit(-1);
+            }
+        }
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start
+        ).count();
+        double megabytes = (double)file.size() * iterations / (1024.0 * 1024.0);
+        std::cout << label << megabytes / seconds << " MB/s\n";
+    };
+
+    measure("ifstream tokens:   ", [&]() {
+        std::ifstream in(path);
+        std::string token;
+        while (in >> token) {}
+        return true;
+    });
+    measure("tokenizer tokens:  ", [&]() {
+        Tokenizer tokens(path, data, file.size());
+        std::string_view token;
+        while (tokens.next(token)) {}
+        return true;
+    });
+    if (isLevel) {
+        measure("level parse:       ", [&]() {
+            LevelFile level;
+            return level.open(path);
+        });
+    }
+    else {
+        measure("assets parse:      ", [&]() {
+            AssetManifest manifest;
+            return Assets::readManifest(path, manifest);
+        });
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    EngineConfig config;
+    std::string assetsPath = "config/assets.txt";
+    std::string bakePath;
+    std::string convertFrom, convertTo;
+    std::string benchPath;
+    size_t benchIterations = 1000;
+    std::string generatePath;
+    GeneratorConfig generator;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        // options that take a value read the next argument
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << arg << " needs a value!\n";
+                exit(-1);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--assets") {
+            assetsPath = value();
+        }
+        else if (arg == "--bake-assets") {
+            bakePath = value();
+        }
+        else if (arg == "--convert-level") {
+            convertFrom = value();
+            convertTo = value();
+        }
+        else if (arg == "--bench-parse") {
+            benchPath = value();
+        }
+        else if (arg == "--iterations") {
+            benchIterations = std::stoul(value());
+        }
+        else if (arg == "--generate-level") {
+            generatePath = value();
+        }
+        else if (arg == "--seed") {
+            generator.seed = std::stoull(value());
+        }
+        else if (arg == "--length") {
+            generator.length = std::stoul(value());
+        }
+        else if (arg == "--tile-density") {
+            generator.tileDensity = std::stof(value());
+        }
+        else if (arg == "--question-ratio") {
+            generator.questionRatio = std::stof(value());
+        }
+        else if (arg == "--decoration-density") {
+            generator.decorationDensity = std::stof(value());
+        }
+        else if (arg == "--pipe-frequency") {
+            generator.pipeFrequency = std::stof(value());
+        }
+        else if (arg == "--hole-frequency") {
+            generator.holeFrequency = std::stof(value());
+        }
+        else if (arg == "--render-thread") {
+            config.renderThread = true;
+        }
+        else if (arg == "--offscreen") {
+            config.backend = RenderBackend::TEXTURE;
+        }
+        else if (arg == "--null-renderer") {
+            config.backend = RenderBackend::RECORD;
+        }
+        else if (arg == "--headless") {
+            config.simulate = true;
+            config.backend = RenderBackend::RECORD;
+        }
+        else if (arg == "--inputs") {
+            config.inputs = value();
+        }
+        else if (arg == "--record-inputs") {
+            config.recordInputs = value();
+        }
+        else if (arg == "--trace") {
+            config.trace = value();
+        }
+        else if (arg == "--instances") {
+            config.instances = std::stoul(value());
+        }
+        else if (arg == "--jobs") {
+            config.jobs = std::stoul(value());
+        }
+        else if (arg == "--level") {
+            config.level = value();
+        }
+        else if (arg == "--frames") {
+            config.frames = std::stoul(value());
+        }
+        else if (arg == "--dump-every") {
+            config.dumpEvery = std::stoul(value());
+        }
+        else if (arg == "--dump-dir") {
+            config.dumpDir = value();
+        }
+        else if (arg == "--golden") {
+            config.goldenDir = value();
+        }
+        else if (arg == "--tolerance") {
+            config.tolerance = std::stoi(value());
+        }
+        else if (arg == "--load-profile") {
+            config.loadProfile = true;
+        }
+        else if (arg == "--load-profile-json") {
+            config.loadProfileJson = value();
+        }
+        else if (arg == "--hot-reload") {
+            config.hotReload = true;
+        }
+        else if (arg == "--eager-assets") {
+            config.lazyAssets = false;
+        }
+        else if (arg == "--texture-budget") {
+            config.textureBudget = std::stoul(value()) * 1024 * 1024;
+        }
+        else if (arg == "--capture-dir") {
+            config.captureDir = value();
+        }
+        else if (arg == "--capture-raw") {
+            config.captureFormat = CaptureFormat::RAW;
+        }
+        else {
+            std::cerr << "Unknown option " << arg << "\n";
+            return -1;
+        }
+    }
+
+    if (!bakePath.empty()) {
+        if (!Assets::bakePack(assetsPath, bakePath)) {
+            return -1;
+        }
+        std::cout << "baked " << assetsPath << " into " << bakePath << "\n";
+        return 0;
+    }
+
+    if (!generatePath.empty()) {
+        LevelGenerator::Counts counts;
+        if (!LevelGenerator::write(generatePath, generator, counts)) {
+            return -1;
+        }
+        std::cout << "generated " << counts.tiles << " tiles and " << counts.decorations
+            << " decorations over " << generator.length << " columns into "
+            << generatePath << "\n";
+        return 0;
+    }
+
+    if (!benchPath.empty()) {
+        return benchParse(benchPath, benchIterations);
+    }
+
+    if (!convertFrom.empty()) {
+        if (!LevelFile::convert(convertFrom, convertTo)) {
+            return -1;
+        }
+        std::cout << "compiled " << convertFrom << " into " << convertTo << "\n";
+        return 0;
+    }
+
+    // a recording knows which level it was made in and how long it ran
+    if (!config.inputs.empty()) {
+        InputScript inputs;
+        if (!inputs.load(config.inputs)) {
+            return -1;
+        }
+        if (config.level.empty()) {
+            config.level = inputs.level();
+        }
+        if (config.frames == 0) {
+            config.frames = inputs.tickCount();
+        }
+    }
+
+    if (config.backend != RenderBackend::WINDOW) {
+        // there is nobody to pick a level from the menu or to close the window
+        if (config.level.empty()) {
+            config.level = "config/level1.txt";
+        }
+        if (config.frames == 0) {
+            config.frames = 600;
+        }
+    }
+
+    // ticks only line up from the start of a level that is loaded
+    // before the first frame, not one picked from the menu
+    if (!config.recordInputs.empty() && config.level.empty()) {
+        std::cerr << "--record-inputs needs --level\n";
+        return -1;
+    }
+
+    GameEngine g(assetsPath, config);
     g.run();
+    return g.exitCode();
 }